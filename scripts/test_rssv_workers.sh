@@ -0,0 +1,39 @@
+#!/bin/bash
+# RSSV with a local coordinator and worker processes on the same machine.
+# The coordinator solves sub-PMPs with NUM_THREADS threads and NUM_WORKERS worker
+# processes (one sub-PMP at a time each); use a binary instance (large_PMP convert)
+# so that the workers share the mmapped instance instead of parsing it again.
+# On several nodes, start the workers there with a <host>:<port> address instead.
+
+# Executable
+CMD=./build/large_PMP
+# Data
+DIR_DATA=./data/Literature/group2/
+INSTANCE=SJC4a
+D_MATRIX="${DIR_DATA}dist_matrix_${INSTANCE}.txt"
+WEIGHTS="${DIR_DATA}cust_weights_${INSTANCE}.txt"
+CAPACITIES="${DIR_DATA}loc_capacities_${INSTANCE}.txt"
+P=10
+IsWeighted_OBJ=true
+
+NUM_THREADS=1
+NUM_WORKERS=3
+ADDRESS="unix:/tmp/large_pmp_rssv_$$.sock"
+# ADDRESS="127.0.0.1:47000" # TCP loopback
+
+metsp="TB_PMP" # Subproblem method
+metfp="TB_PMP" # Final problem method
+SIZE_SUBPROBLEMS=100
+
+INSTANCE_ARGS="-p $P -dm $D_MATRIX -w $WEIGHTS -c $CAPACITIES -IsWeighted_ObjFunc $IsWeighted_OBJ"
+
+# Workers retry until the coordinator listens
+for ((k = 1; k <= NUM_WORKERS; k++)); do
+    $CMD worker $INSTANCE_ARGS -rssv_address $ADDRESS > ./outputs/rssv_worker_$k.log 2>&1 &
+done
+
+$CMD $INSTANCE_ARGS -method RSSV -method_rssv_sp $metsp -method_rssv_fp $metfp \
+    -size_subproblems_rssv $SIZE_SUBPROBLEMS -th $NUM_THREADS \
+    -rssv_address $ADDRESS -rssv_remote_workers $NUM_WORKERS -o ./outputs/solutions/rssv_workers
+
+wait
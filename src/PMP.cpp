@@ -160,22 +160,37 @@ void PMP::run(string Method_name){
 
 void PMP::run_GAP(unordered_set<uint_t> p_locations){
     try{
-        this->p_locations = p_locations;
-
         VERBOSE = false; 
+        isFeasible_Solver = false;
 
-        initILP();
-        // Set the output to a non-verbose mode
-        cplex.setParam(IloCplex::Param::MIP::Display, 0);
-        cplex.setOut(env.getNullStream());  // Disable console output
-        // cplex.setLogStream(fileStream);     // Redirect log to a file stream
+        if (!model_built){
+            this->p_locations = p_locations;
+            initILP();
+            // Set the output to a non-verbose mode
+            cplex.setParam(IloCplex::Param::MIP::Display, 0);
+            cplex.setOut(env.getNullStream());  // Disable console output
+            // cplex.setLogStream(fileStream);     // Redirect log to a file stream
+            model_built = true;
+        }else{
+            updateGAP(p_locations); // same model, only the y bounds of the swapped locations change
+        }
         // exportILP(cplex);
         solveILP();
 
         bool verb = false;
+        last_assignment.clear();
         if (cplex.getStatus() == IloAlgorithm::Optimal || cplex.getStatus() == IloAlgorithm::Feasible){
           
             isFeasible_Solver = true;
+            if (is_BinModel){
+                for(IloInt i = 0; i < num_customers; i++){
+                    IloNumArray vals = xValues(i);
+                    for(IloInt k = 0; k < vals.getSize(); k++)
+                        if (vals[k] > 0.5 && p_locations.find(instance->getLocations()[x_locs[i][k]]) != p_locations.end())
+                            last_assignment.emplace_back(i, k);
+                    vals.end();
+                }
+            }
             if (verb){
                 if(is_BinModel == true) {printSolution(cplex,x_bin,y);}
                 else {printSolution(cplex,x_cont,y);}
@@ -192,46 +207,158 @@ void PMP::run_GAP(unordered_set<uint_t> p_locations){
     }
 }
 
+/*
+ * Move the built GAP model to a new set of p locations: fix y to 0/1 for the
+ * locations that left/entered the set. The LP relaxation restarts from the
+ * previous basis; the binary model also gets the previous assignment of the
+ * customers whose location stays open as a MIP start, repaired by CPLEX.
+ */
+void PMP::updateGAP(const unordered_set<uint_t>& p_locations){
+
+    for (auto loc:this->p_locations){
+        auto index_loc = instance->getLocIndex(loc);
+        if (index_loc != NO_INDEX && p_locations.find(loc) == p_locations.end()) y[index_loc].setBounds(0, 0);
+    }
+    for (auto loc:p_locations){
+        auto index_loc = instance->getLocIndex(loc);
+        if (index_loc != NO_INDEX && this->p_locations.find(loc) == this->p_locations.end()) y[index_loc].setBounds(1, 1);
+    }
+    this->p_locations = p_locations;
+
+    if (is_BinModel && !last_assignment.empty()){
+        if (cplex.getNMIPStarts() > 0) cplex.deleteMIPStarts(0, cplex.getNMIPStarts());
+        IloNumVarArray startVar(env);
+        IloNumArray startVal(env);
+        for (auto a:last_assignment){
+            auto loc = instance->getLocations()[x_locs[a.first][a.second]];
+            if (p_locations.find(loc) == p_locations.end()) continue;
+            startVar.add(x_bin[a.first][a.second]);
+            startVal.add(1);
+        }
+        cplex.addMIPStart(startVar, startVal, IloCplex::MIPStartRepair);
+        startVar.end();
+        startVal.end();
+    }
+}
+
 void PMP::initVars(){
 
     IloEnv env = model.getEnv();
 
-    // alloc memory and add to model forvars y_j
+    // whole arrays are added to the model, names only on request (setNameVars)
     y = IloBoolVarArray(env, static_cast<IloInt>(num_facilities));
-    for(IloInt j = 0; j < static_cast<IloInt>(num_facilities); j++){
-        char name[50];
-        sprintf(name, "y(%ld)", j+1);
-        this->y[j].setName(name);
-        model.add(this->y[j]);
+    model.add(this->y);
+    if (name_vars){
+        for(IloInt j = 0; j < static_cast<IloInt>(num_facilities); j++){
+            char name[50];
+            sprintf(name, "y(%ld)", j+1);
+            this->y[j].setName(name);
+        }
     }
 
-    // alloc memory forvars x_ij and add to model
+    // alloc memory forvars x_ij (admissible pairs only) and add to model
+    initAdmissiblePairs();
     if(is_BinModel == true){
         this->x_bin = BoolVarMatrix(env, static_cast<IloInt>(num_customers));
-        for(IloInt i = 0; i < static_cast<IloInt>(num_customers); i++)
-            this->x_bin[i] = IloBoolVarArray(env, static_cast<IloInt>(num_facilities));
-        
-        for(IloInt i = 0; i < static_cast<IloInt>(num_customers); i++)
-            for(IloInt j = 0; j < static_cast<IloInt>(num_facilities); j++){
-                char name[50];
-                sprintf(name, "x(%ld,%ld)", i+1, j+1);
-                this->x_bin[i][j].setName(name);
-                model.add(this->x_bin[i][j]);
-            }
+        for(IloInt i = 0; i < static_cast<IloInt>(num_customers); i++){
+            this->x_bin[i] = IloBoolVarArray(env, static_cast<IloInt>(x_locs[i].size()));
+            model.add(this->x_bin[i]);
+        }
     }else{
         this->x_cont = NumVarMatrix(env, static_cast<IloInt>(num_customers));
-        for(IloInt i = 0; i < static_cast<IloInt>(num_customers); i++)
-            this->x_cont[i] = IloNumVarArray(env, static_cast<IloInt>(num_facilities),0.0,1.0, ILOFLOAT);
-
-        for(IloInt i = 0; i < static_cast<IloInt>(num_customers); i++)
-            for(IloInt j = 0; j < static_cast<IloInt>(num_facilities); j++){
-                char name[50];
-                sprintf(name, "x(%ld,%ld)", i+1, j+1);
-                this->x_cont[i][j].setName(name);
-                model.add(this->x_cont[i][j]);
+        for(IloInt i = 0; i < static_cast<IloInt>(num_customers); i++){
+            this->x_cont[i] = IloNumVarArray(env, static_cast<IloInt>(x_locs[i].size()),0.0,1.0, ILOFLOAT);
+            model.add(this->x_cont[i]);
+        }
+    }
+    if (!name_vars) return;
+    for(IloInt i = 0; i < static_cast<IloInt>(num_customers); i++)
+        for(IloInt k = 0; k < static_cast<IloInt>(x_locs[i].size()); k++){
+            char name[50];
+            sprintf(name, "x(%ld,%ld)", i+1, x_locs[i][k]+1);
+            if (is_BinModel) this->x_bin[i][k].setName(name);
+            else this->x_cont[i][k].setName(name);
+        }
+
+}
+
+/*
+ * Pairs (i,j) that get a variable x_ij: customer i can be served by location j, i.e. the
+ * distance is kept (not DEFAULT_DISTANCE, see dist_knn/dist_cutoff) and within the
+ * threshold distance if there is one; with sparse storage only the kept distances of a
+ * customer are read. A customer with no such pair gets back the pairs
+ * dropped at DEFAULT_DISTANCE, so that the model is built as before; the threshold stays
+ * a hard filter, a customer with no location within it makes the model infeasible.
+ */
+void PMP::initAdmissiblePairs(){
+
+    auto threshold_dist = instance->get_ThresholdDist();
+    x_locs.assign(num_customers, vector<IloInt>());
+    idx_t num_pairs = 0, num_fallback = 0, num_unreachable = 0;
+    vector<pair<uint_t, dist_t>> kept;
+    for(IloInt i = 0; i < num_customers; i++){
+        auto& locs = x_locs[i];
+        if (instance->keptDistsByIdx(i, kept)){ // sparse storage: only the kept distances of i
+            for (auto& [j, dist] : kept){
+                if (dist >= DEFAULT_DISTANCE || (threshold_dist > 0 && dist > threshold_dist)) continue;
+                locs.push_back(j);
             }
+        }else{
+            for(IloInt j = 0; j < num_facilities; j++){
+                auto dist = instance->distByIdx(j,i);
+                if (dist >= DEFAULT_DISTANCE || (threshold_dist > 0 && dist > threshold_dist)) continue;
+                locs.push_back(j);
+            }
+        }
+        if (locs.empty()){
+            for(IloInt j = 0; j < num_facilities; j++)
+                if (threshold_dist <= 0 || instance->distByIdx(j,i) <= threshold_dist) locs.push_back(j);
+            if (locs.empty()) num_unreachable++;
+            else num_fallback++;
+        }
+        locs.shrink_to_fit();
+        num_pairs += locs.size();
+    }
+
+    if (VERBOSE){
+        cout << "[INFO] Variables x_ij: " << num_pairs << " admissible pairs of " << idx_t(num_customers) * num_facilities << endl;
+        if (threshold_dist > 0) cout << "Threshold Distance: " << threshold_dist << endl;
+    }
+    if (num_fallback > 0) cout << "[WARN] " << num_fallback << " customers without kept distance keep their pairs at DEFAULT_DISTANCE" << endl;
+    if (num_unreachable > 0) cout << "[WARN] " << num_unreachable << " customers have no location within the threshold distance " << threshold_dist << ", the model is infeasible" << endl;
+}
+
+// objective coefficients of the row x[i]: (w_i *) d_ij
+IloNumArray PMP::distCoefs(IloInt i, bool weighted){
+    IloNumArray coefs(env, static_cast<IloInt>(x_locs[i].size()));
+    for(IloInt k = 0; k < static_cast<IloInt>(x_locs[i].size()); k++){
+        if (weighted) coefs[k] = instance->weightByIdx(i) * instance->distByIdx(x_locs[i][k],i);
+        else coefs[k] = instance->distByIdx(x_locs[i][k],i);
     }
+    return coefs;
+}
+
+// values of y in the current solution (one getValues call), end() it after use
+IloNumArray PMP::yValues(){
+    IloNumArray vals(env);
+    cplex.getValues(vals, y);
+    return vals;
+}
 
+// values of the row x[i] in the current solution (one getValues call), end() it after use
+IloNumArray PMP::xValues(IloInt i){
+    IloNumArray vals(env);
+    if (is_BinModel) cplex.getValues(vals, x_bin[i]);
+    else cplex.getValues(vals, x_cont[i]);
+    return vals;
+}
+
+// position k of location index j in x[i] (x_locs[i] is sorted), -1 if x_ij is not a variable
+IloInt PMP::xSlot(IloInt i, IloInt j){
+    auto& locs = x_locs[i];
+    auto it = lower_bound(locs.begin(), locs.end(), j);
+    if (it == locs.end() || *it != j) return -1;
+    return it - locs.begin();
 }
 
 void PMP::addMIPStartSolution(){
@@ -247,7 +374,7 @@ void PMP::addMIPStartSolution(){
     IloNumArray startVal_y(env);
 
     auto p_locations = sol.get_pLocations();
-    auto assignments = sol.getAssignments();
+    const auto& assign = sol.getCapAssignment();
 
     for(IloInt j = 0; j < num_facilities; j++){
         auto loc = instance->getLocations()[j];
@@ -265,17 +392,19 @@ void PMP::addMIPStartSolution(){
     IloNumVarArray startVar_x(env);
     IloNumArray startVal_x(env);
 
-    for (auto cust:instance->getCustomers()) {
-        for (auto a:assignments[cust]){ 
+    for (IloInt i = 0; i < num_customers; i++) {
+        for (auto a:assign.getEntries(i)){ 
             auto loc = a.node;
             auto dem_used = a.usage;
+            auto k = xSlot(i, instance->getLocIndex(loc));
+            if (k < 0) continue; // not admissible, left to CPLEX
 
             if (is_BinModel){
-                startVar_x.add(x_bin[instance->getCustIndex(cust)][instance->getLocIndex(loc)]);
+                startVar_x.add(x_bin[i][k]);
                 startVal_x.add(dem_used);
             }else{
-                startVar_x.add(x_cont[instance->getCustIndex(cust)][instance->getLocIndex(loc)]);
-                startVal_x.add(dem_used / instance->getCustWeight(cust));
+                startVar_x.add(x_cont[i][k]);
+                startVal_x.add(dem_used / instance->weightByIdx(i));
             }
         }
     }
@@ -291,6 +420,7 @@ void PMP::initILP(){
 
     try{
 
+        auto cpu0 = get_cpu_time_pmp();
         model = IloModel(env);
         initVars();
 
@@ -301,6 +431,8 @@ void PMP::initILP(){
 
         this->cplex = IloCplex(this->model);
         // exportILP(cplex);
+        this->timeBuild = get_cpu_time_pmp() - cpu0;
+        if (VERBOSE) cout << "[INFO] CPLEX model built in " << timeBuild << "s" << endl;
 
 
     } catch (IloException& e) {
@@ -321,14 +453,15 @@ void PMP::createModel(IloModel model, VarType x, IloBoolVarArray y){
 
     objFunction(model,x);
     constr_DemandSatif(model,x);
-    if(strcmp(typeProb,"GAP") == 0) {constr_GAP(model,y);}
+    if(strcmp(typeProb,"GAP") == 0) {constr_GAP(y);}
     if(strcmp(typeProb,"GAP") != 0) {constr_pLocations(model,y);}
     if(strcmp(typeProb,"CPMP") == 0 || strcmp(typeProb,"cPMP") == 0 || strcmp(typeProb,"GAP") == 0){constr_maxCapacity(model,x,y);}
     if(strcmp(typeProb,"PMP") == 0 || strcmp(typeProb,"pmp") == 0  ){constr_UBpmp(model,x,y);}
     if(CoverModel) {constr_Cover(model,y);}
     if(CoverModel_n2) {constr_Cover_n2(model,y);}
-    if (UpperBound != 0) {constr_UpperBound(model,x);}
-    if (instance->get_ThresholdDist() > 0) {constr_MaxDistance(model,x);}
+    // GAP: always added, so that it can be tightened/relaxed when the model is reused
+    if (UpperBound != 0 || strcmp(typeProb,"GAP") == 0) {constr_UpperBound(model,x);}
+    // max distance: pairs beyond the threshold have no variable (initAdmissiblePairs)
 }
 
 
@@ -348,20 +481,12 @@ void PMP::objFunction(IloModel model, VarType x){
     
     IloEnv env = model.getEnv();
     IloExpr objExpr(env);
-    for(IloInt i = 0; i < num_customers; i++)
-        for(IloInt j = 0; j < num_facilities; j++){
-            // if(strcmp(typeProb,"PMP") == 0 || strcmp(typeProb,"pmp") == 0  ){objExpr += instance->getRealDist(j+1,i+1) * x[i][j];}
-            // else{objExpr += instance->getWeightedDist(j+1,i+1) * x[i][j];}
-            auto loc = instance->getLocations()[j];
-            auto cust = instance->getCustomers()[i];
-
-            if (is_weighted_obj_func){objExpr += instance->getWeightedDist(loc,cust) * x[i][j];
-            }else{objExpr += instance->getRealDist(loc,cust) * x[i][j];}
-
-            // objExpr += instance->getWeightedDist(loc,cust) * x[i][j];
-            // objExpr += instance->getRealDist(loc,cust) * x[i][j];
-            // objExpr +=  x[i][j];
-        }
+    for(IloInt i = 0; i < num_customers; i++){
+        // one scalar product per customer row instead of a term per pair
+        IloNumArray coefs = distCoefs(i, is_weighted_obj_func);
+        objExpr += IloScalProd(coefs, x[i]);
+        coefs.end();
+    }
     model.add(IloMinimize(env, objExpr));
     objExpr.end();
 }
@@ -373,14 +498,10 @@ void PMP::constr_DemandSatif(IloModel model, VarType x){
     if (VERBOSE){cout << "[INFO] Adding Demand Satisfied Constraints "<< endl;}
 
     IloEnv env = model.getEnv();
-    for(IloInt i = 0; i < num_customers; i++){
-        IloExpr expr(env);
-        for(IloInt j = 0; j < num_facilities; j++){
-            expr += x[i][j];
-        }
-        model.add(expr == 1);
-        expr.end();
-    }
+    IloRangeArray demand(env);
+    for(IloInt i = 0; i < num_customers; i++)
+        demand.add(IloSum(x[i]) == 1);
+    model.add(demand);
 
 }
 
@@ -402,9 +523,12 @@ void PMP::constr_UBpmp(IloModel model, VarType x, IloBoolVarArray y){
 
     if (VERBOSE){cout << "[INFO] Adding UB Constraints "<< endl;}
 
+    IloEnv env = model.getEnv();
+    IloRangeArray ub(env);
     for(IloInt i = 0; i < num_customers; i++)
-        for(IloInt j = 0; j < num_facilities; j++)
-            model.add(x[i][j] <= y[j]);
+        for(IloInt k = 0; k < static_cast<IloInt>(x_locs[i].size()); k++)
+            ub.add(x[i][k] - y[x_locs[i][k]] <= 0);
+    model.add(ub);
 
 }
 
@@ -416,21 +540,33 @@ void  PMP::constr_maxCapacity(IloModel model, VarType x, IloBoolVarArray y){
 
     if (VERBOSE){cout << "[INFO] Adding Max Capacity Constraints "<< endl;}
 
+    // columns of x gathered in one pass over the admissible pairs, then one scalar product per location
+    typedef typename std::decay<decltype(x[0])>::type VarArray;
     IloEnv env = model.getEnv();
+    vector<VarArray> col_vars;
+    vector<IloNumArray> col_coefs;
+    col_vars.reserve(num_facilities);
+    col_coefs.reserve(num_facilities);
     for(IloInt j = 0; j < num_facilities; j++){
-        IloExpr expr(env);
-        auto loc = instance->getLocations()[j];
-        for(IloInt i = 0; i < num_customers; i++){
-            auto cust = instance->getCustomers()[i];
-            expr += IloNum(instance->getCustWeight(cust)) * x[i][j];
+        col_vars.emplace_back(env);
+        col_coefs.emplace_back(env);
+    }
+    for(IloInt i = 0; i < num_customers; i++)
+        for(IloInt k = 0; k < static_cast<IloInt>(x_locs[i].size()); k++){
+            col_vars[x_locs[i][k]].add(x[i][k]);
+            col_coefs[x_locs[i][k]].add(IloNum(instance->weightByIdx(i)));
         }
-        model.add(expr <= IloNum(instance->getLocCapacity(loc)) * y[j]);
-        expr.end();
+    IloRangeArray capacity(env);
+    for(IloInt j = 0; j < num_facilities; j++){
+        capacity.add(IloScalProd(col_coefs[j], col_vars[j]) - IloNum(instance->capacityByIdx(j)) * y[j] <= 0);
+        col_vars[j].end();
+        col_coefs[j].end();
     }
+    model.add(capacity);
 
 }
 
-void PMP::constr_GAP(IloModel model, IloBoolVarArray y){
+void PMP::constr_GAP(IloBoolVarArray y){
 
     if (VERBOSE){cout << "[INFO] Adding GAP fixed p Constraints "<< endl;}
 
@@ -438,11 +574,12 @@ void PMP::constr_GAP(IloModel model, IloBoolVarArray y){
 
     for(auto loc:locations){
         auto index_loc = instance->getLocIndex(loc);
-        if (index_loc != 10000000 && (p_locations.find(loc) == p_locations.end())){
-            model.add(y[index_loc] == 0);
+        // fixed through the bounds of y (not constraints), updateGAP changes them in place
+        if (index_loc != NO_INDEX && (p_locations.find(loc) == p_locations.end())){
+            y[index_loc].setBounds(0, 0);
             // cout << "index: " << index_loc << " loc: " << loc
-        }else if (index_loc != 10000000 && (p_locations.find(loc) != p_locations.end())){
-            model.add(y[index_loc] == 1);
+        }else if (index_loc != NO_INDEX && (p_locations.find(loc) != p_locations.end())){
+            y[index_loc].setBounds(1, 1);
             // cout << "index: " << index_loc << " loc: " << loc << endl;
         }
     }
@@ -571,35 +708,18 @@ void PMP::constr_UpperBound (IloModel model, VarType x){
 
     IloEnv env = model.getEnv();
     IloExpr objExpr(env);
-    for(IloInt i = 0; i < num_customers; i++)
-        for(IloInt j = 0; j < num_facilities; j++){
-            // if(strcmp(typeProb,"PMP") == 0 || strcmp(typeProb,"pmp") == 0  ){objExpr += instance->getRealDist(j+1,i+1) * x[i][j];}
-            // else{objExpr += instance->getWeightedDist(j+1,i+1) * x[i][j];}
-            auto loc = instance->getLocations()[j];
-            auto cust = instance->getCustomers()[i];
-            objExpr += instance->getWeightedDist(loc,cust) * x[i][j];
-        }
-    model.add(objExpr <= UpperBound);
+    for(IloInt i = 0; i < num_customers; i++){
+        IloNumArray coefs = distCoefs(i, true); // sum (wi * dij * xij)
+        objExpr += IloScalProd(coefs, x[i]);
+        coefs.end();
+    }
+    ub_constr = IloRange(env, -IloInfinity, objExpr, UpperBound != 0 ? UpperBound : IloInfinity);
+    model.add(ub_constr);
     objExpr.end();
 
 
 }
 
-template <typename VarType>
-void PMP::constr_MaxDistance(IloModel model, VarType x){
-
-    if (VERBOSE){cout << "[INFO] Adding Max Distance Constraints "<< endl; cout << "Threshold Distance: " << instance->get_ThresholdDist() << endl;}
-
-    for(IloInt i = 0; i < num_customers; i++)
-        for(IloInt j = 0; j < num_facilities; j++){
-            auto loc = instance->getLocations()[j];
-            auto cust = instance->getCustomers()[i];
-            if (instance->getRealDist(loc,cust) > instance->get_ThresholdDist())
-                model.add(x[i][j] == 0);
-        }
-}
-
-
 // void PMP::printSolution(IloCplex& cplex, BoolVarMatrix x, IloBoolVarArray y){
 template <typename VarType>  
 void PMP::printSolution(IloCplex& cplex, VarType x, IloBoolVarArray y){
@@ -656,24 +776,20 @@ Solution_cap PMP::getSolution_cap(){
     // cout << "[INFO] Getting solution capacitated" << endl;
 
     try{
+        auto cpu0 = get_cpu_time_pmp();
         unordered_set<uint_t> p_locations;
         auto locations = instance->getLocations();
 
+        IloNumArray y_vals = yValues();
+        vector<bool> is_open(num_facilities, false);
         for(IloInt j = 0; j < num_facilities; j++){
-            auto loc = instance->getLocations()[j];
-            if (cplex.getValue(y[j]) > 0.5)
-                p_locations.insert(loc);
+            is_open[j] = y_vals[j] > 0.5;
+            if (is_open[j]) p_locations.insert(locations[j]);
         }
+        y_vals.end();
 
-        unordered_map<uint_t, dist_t> loc_usages; // p location -> usage from <0, capacity>
-        unordered_map<uint_t, dist_t> cust_satisfactions; // customer -> satisfaction from <0, weight>
-        unordered_map<uint_t, assignment> assignments; // customer -> assignment (p location, usage, weighted distance)
-
-        for(auto p_loc:p_locations) loc_usages[p_loc] = 0;
-        for(auto cust:instance->getCustomers()) {
-            cust_satisfactions[cust] = 0;
-            assignments[cust] = assignment{};
-        }
+        // usages, satisfactions and assignments (p location, usage, distance) by instance index
+        auto assign = make_shared<CapAssignment>(num_facilities, num_customers);
 
         // cout << "p_loc = ";
         // for(auto p_loc:p_locations)
@@ -683,43 +799,45 @@ Solution_cap PMP::getSolution_cap(){
         bool is_weighted_obj_func = instance->get_isWeightedObjFunc();
         dist_t objtest = 0.0;
 
-        for(IloInt j = 0; j < num_facilities; j++){
-            if (cplex.getValue(y[j]) > 0.5){
+        for(IloInt i = 0; i < num_customers; i++){
+            IloNumArray x_vals = xValues(i);
+            for(IloInt k = 0; k < static_cast<IloInt>(x_locs[i].size()); k++){
+                auto j = x_locs[i][k];
+                if (is_open[j]){
 
-                auto loc = instance->getLocations()[j];
-                for(IloInt i = 0; i < num_customers; i++){
-                    auto cust = instance->getCustomers()[i];
-                    
+                    auto loc = locations[j];
                     auto qtde_used = 0.0;
-                    if (is_BinModel && cplex.getValue(x_bin[i][j]) > 0.5){
-                        qtde_used = cplex.getValue(x_bin[i][j]);
-                    }else if (!is_BinModel && cplex.getValue(x_cont[i][j]) > 0){
-                        qtde_used = cplex.getValue(x_cont[i][j]);
+                    if (is_BinModel && x_vals[k] > 0.5){
+                        qtde_used = x_vals[k];
+                    }else if (!is_BinModel && x_vals[k] > 0){
+                        qtde_used = x_vals[k];
                     }
 
                     if (qtde_used > 0.0001) {
-                        auto dem_used = qtde_used*instance->getCustWeight(cust);
-                        loc_usages[loc] += dem_used;
-                        cust_satisfactions[cust] += dem_used;
-                        assignments[cust].emplace_back(my_tuple{loc, dem_used, instance->getRealDist(loc, cust)});
+                        auto dem_used = qtde_used*instance->weightByIdx(i);
+                        auto dist = instance->distByIdx(j,i);
+                        assign->add(i, j, my_tuple{loc, dem_used, dist});
                         
-                        auto obj_increment =  instance->getRealDist(loc, cust) * qtde_used;
-                        if (is_weighted_obj_func) obj_increment = dem_used * instance->getRealDist(loc, cust);
+                        auto obj_increment =  dist * qtde_used;
+                        if (is_weighted_obj_func) obj_increment = dem_used * dist;
                         objtest += obj_increment;
 
 
                         // cout << "loc: " << loc << " cust: " << cust << " qtde_used: " << qtde_used << " dem_used: " << dem_used << " dist: " << instance->getRealDist(loc, cust) << " obj_increment: " << obj_increment << endl;
                     }
-                    if(loc_usages[loc] >= instance->getLocCapacity(loc) + 0.0001){ cerr << "ERROR: usage > capacity" << endl;  exit(1);}
-                    if(cust_satisfactions[cust] >= instance->getCustWeight(cust) + 0.001 ){ cerr << "ERROR: satisfaction > weight" << endl; exit(1);}
+                    if(assign->loc_usages[j] >= instance->capacityByIdx(j) + 0.0001){ cerr << "ERROR: usage > capacity" << endl;  exit(1);}
+                    if(assign->cust_satisfactions[i] >= instance->weightByIdx(i) + 0.001 ){ cerr << "ERROR: satisfaction > weight" << endl; exit(1);}
 
                     
                 }
             }
-
+            x_vals.end();
 
         }
-        Solution_cap sol(instance, p_locations, loc_usages, cust_satisfactions, assignments);
+        assign->pack();
+        this->timeExtract = get_cpu_time_pmp() - cpu0;
+        if (VERBOSE) cout << "[INFO] CPLEX solution extracted in " << timeExtract << "s" << endl;
+        Solution_cap sol(instance, p_locations, assign);
         return sol;
 
     } catch (IloException& e) {
@@ -739,11 +857,16 @@ Solution_std PMP::getSolution_std(){
     // auto p = instance->get_p();
     // auto locations = instance->getLocations();
     
+    auto cpu0 = get_cpu_time_pmp();
+    IloNumArray y_vals = yValues();
     for(IloInt j = 0; j < num_facilities; j++){
             auto loc = instance->getLocations()[j];
-            if (cplex.getValue(y[j]) > 0.5)
+            if (y_vals[j] > 0.5)
                 p_locations.insert(loc);
         }
+    y_vals.end();
+    this->timeExtract = get_cpu_time_pmp() - cpu0;
+    if (VERBOSE) cout << "[INFO] CPLEX solution extracted in " << timeExtract << "s" << endl;
 
     Solution_std sol(instance, p_locations);
 
@@ -791,30 +914,23 @@ void PMP::saveVars(const std::string& filename,const string& Method){
         cout.rdbuf(stream_buffer_file); // redirect cout to file
     }
 
+    IloNumArray y_vals = yValues();
     for(IloInt j = 0; j < num_facilities; j++){
         auto loc = instance->getLocations()[j];
-        if (cplex.getValue(this->y[j]) > 0.5)
-            cout << "y[" << loc << "] = " << cplex.getValue(this->y[j]) << endl;
+        if (y_vals[j] > 0.5)
+            cout << "y[" << loc << "] = " << y_vals[j] << endl;
     }
+    y_vals.end();
 
-    if (!is_BinModel){
-        for(IloInt j = 0; j < num_facilities; j++){
-            auto loc = instance->getLocations()[j];
-            for(IloInt i = 0; i < num_customers; i++){
-                auto cust = instance->getCustomers()[i];
-                if (cplex.getValue(x_cont[i][j]) > 0.001)
-                    cout << "x[" << cust << "][" << loc << "] = " << cplex.getValue(x_cont[i][j]) << endl;
-            }
-        }
-    }else{
-        for(IloInt j = 0; j < num_facilities; j++){
-        auto loc = instance->getLocations()[j];
-        for(IloInt i = 0; i < num_customers; i++){
-            auto cust = instance->getCustomers()[i];
-            if (cplex.getValue(x_bin[i][j]) > 0.001)
-                cout << "x[" << cust << "][" << loc << "] = " << cplex.getValue(x_bin[i][j]) << endl;
-            }
+    for(IloInt i = 0; i < num_customers; i++){
+        auto cust = instance->getCustomers()[i];
+        IloNumArray x_vals = xValues(i);
+        for(IloInt k = 0; k < static_cast<IloInt>(x_locs[i].size()); k++){
+            auto loc = instance->getLocations()[x_locs[i][k]];
+            if (x_vals[k] > 0.001)
+                cout << "x[" << cust << "][" << loc << "] = " << x_vals[k] << endl;
         }
+        x_vals.end();
     }
 
     cout.rdbuf(stream_buffer_cout);
@@ -968,7 +1084,7 @@ void PMP::setSolution_cap(Solution_cap sol){
         IloBoolArray startVal_y(env);
 
         auto p_locations = sol.get_pLocations();
-        auto sol_assignments = sol.getAssignments();
+        const auto& sol_assign = sol.getCapAssignment();
 
         // Set y variables based on the selected locations in the solution
         for(IloInt j = 0; j < num_facilities; j++) {
@@ -984,22 +1100,19 @@ void PMP::setSolution_cap(Solution_cap sol){
             }        
         }
 
-        std::vector<std::vector<IloNum>> X_matrix(num_customers, std::vector<IloNum>(num_facilities));
-        for(auto& num_customers : X_matrix) {
-            std::fill(num_customers.begin(), num_customers.end(), IloNum(0));
+        // indexed like x: customer index, position in x_locs[i]
+        std::vector<std::vector<IloNum>> X_matrix(num_customers);
+        for(IloInt i = 0; i < num_customers; i++) {
+            X_matrix[i].assign(x_locs[i].size(), IloNum(0));
         }
 
 
         for(IloInt i = 0; i < num_customers; i++){
-            auto cust = instance->getCustomers()[i];
-            for(IloInt j = 0; j < num_facilities; j++){
-                    auto loc_j = instance->getLocations()[j];
-                for(auto a:sol_assignments[cust]) {
-                    auto loc = a.node;
-                    if (loc == loc_j) {
-                        X_matrix[i][j] = IloNum(1);
-                    }    
-                }
+            for(auto a:sol_assign.getEntries(i)) {
+                auto k = xSlot(i, instance->getLocIndex(a.node));
+                if (k >= 0) {
+                    X_matrix[i][k] = IloNum(1);
+                }    
             }
         }
 
@@ -1009,9 +1122,9 @@ void PMP::setSolution_cap(Solution_cap sol){
 
         for(IloInt i = 0; i < num_customers; i++){
             IloNumArray startVal_x_i(env);
-            for(IloInt j = 0; j < num_facilities; j++){
-                startVal_x_i.add(X_matrix[i][j]);
-                // startVar_x.add(x_cont[i][j]);
+            for(IloInt k = 0; k < static_cast<IloInt>(x_locs[i].size()); k++){
+                startVal_x_i.add(X_matrix[i][k]);
+                // startVar_x.add(x_cont[i][k]);
             }
             startVal_x.add(startVal_x_i);
             startVar_x.add(x_cont[i]);
@@ -1053,9 +1166,14 @@ void PMP::setSolution_cap(Solution_cap sol){
 
 void PMP::setUpperBound(double UB){
     this->UpperBound = UB;
+    if (model_built) ub_constr.setUB(UB != 0 ? UB : IloInfinity);
 }
 
 void PMP::setTimeLimit(double CLOCK_LIMIT){
     // this->timeLimit =  static_cast<int>(ceil(CLOCK_LIMIT));
     this->timeLimit =  CLOCK_LIMIT;
+}
+
+void PMP::setNameVars(bool name_vars){
+    this->name_vars = name_vars;
 }
\ No newline at end of file
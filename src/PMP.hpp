@@ -57,6 +57,8 @@ class PMP
         // void saveNumConstraints();
         double timeSolver;
         double timePMP;
+        double timeBuild = 0;   // CPLEX model construction
+        double timeExtract = 0; // reading the solution back from CPLEX
         bool is_BinModel;
         bool VERBOSE;
         string typeServ;
@@ -73,6 +75,7 @@ class PMP
         void setTimeLimit(double timeLimit);
         void setMIPStartSolution(Solution_cap sol);
         void setUseMIPStart(bool useMIPStart);
+        void setNameVars(bool name_vars);
         // void setInitialSolution(Solution_cap sol);
 
     private:
@@ -95,7 +98,15 @@ class PMP
         double timeLimit = CLOCK_LIMIT_CPLEX;
         bool useMIPStart=false;
         Solution_cap initial_solution;
-
+        bool name_vars = false; // names only help when exporting/debugging the model
+
+        // x[i][k] is the variable of customer index i and location index x_locs[i][k]
+        vector<vector<IloInt>> x_locs; // customer index -> admissible location indexes, sorted
+        void initAdmissiblePairs();
+        IloInt xSlot(IloInt i, IloInt j);
+        IloNumArray distCoefs(IloInt i, bool weighted);
+        IloNumArray yValues();
+        IloNumArray xValues(IloInt i);
         void initVars();
         void initILP        (void);
 
@@ -125,7 +136,12 @@ class PMP
         void constr_maxCapacity (IloModel model, VarType x, IloBoolVarArray y);
 
         unordered_set<uint_t> p_locations; // p selected locations
-        void constr_GAP (IloModel model, IloBoolVarArray y);
+        void constr_GAP (IloBoolVarArray y);
+        // GAP model kept between run_GAP calls, only the y bounds change
+        bool model_built=false;
+        IloRange ub_constr;
+        vector<pair<IloInt, IloInt>> last_assignment; // (i,k) with x_bin[i][k]=1 in the last GAP solution
+        void updateGAP (const unordered_set<uint_t>& p_locations);
 
         void constr_Cover (IloModel model, IloBoolVarArray y);
         void constr_Cover_n2 (IloModel model, IloBoolVarArray y);
@@ -135,9 +151,6 @@ class PMP
         void constr_UpperBound (IloModel model, VarType x);
 
         void addMIPStartSolution();
-
-        template <typename VarType>
-        void constr_MaxDistance (IloModel model, VarType x);
         
 
 };
@@ -17,6 +17,9 @@ RSSV::RSSV(const shared_ptr<Instance>& instance, uint_t seed, uint_t n):instance
     for (auto loc : instance->getLocations()) {
         weights[loc] = DEFAULT_WEIGHT;
     }
+    for (uint_t j = 0; j < N; j++) loc_index[instance->getLocations()[j]] = j;
+    kernel_neighbors.resize(N);
+    kernel_built.reset(new once_flag[N]);
 }
 
 shared_ptr<Instance> RSSV::run(uint_t thread_cnt, const string& method_sp) {
@@ -46,43 +49,150 @@ shared_ptr<Instance> RSSV::run_impl(uint_t thread_cnt, const string& method_sp,
         n = min(static_cast<uint_t>(1.5 * instance->get_p()), N);
     }
 
-    sem.setCount(thread_cnt);
     cout << "thread cnt: " << thread_cnt << endl << endl;
 
-    auto start_time = tick();
-    vector<thread> threads;
-    for (uint_t i = 1; i <= M; i += thread_cnt) {
-        for (uint_t j = 0; j < thread_cnt && (i + j) <= M; ++j) {
-            int seed_thread = seed_rssv + i + j;
-            cout << "Thread " << i + j << " created with seed " << seed_thread << endl;
-            
-            if (is_cap) {
-                threads.emplace_back([this, seed_thread]() {
-                    std::mt19937 gen(seed_thread); // Local to each thread
-                    this->solveSubproblemTemplate<Solution_cap>(seed_thread, true);
-                });
-            } else {
-                threads.emplace_back([this, seed_thread]() {
-                    std::mt19937 gen(seed_thread); // Local to each thread
-                    this->solveSubproblemTemplate<Solution_std>(seed_thread, false);
-                });
-            }
+    /*
+     * Remote RSSV workers get one pool worker each on top of the thread_cnt local ones:
+     * it forwards the seed of its sub-PMP to the worker and votes with the returned p-set,
+     * so local and remote workers take the next sub-PMP from the same queue.
+     */
+    local_thread_cnt = max(thread_cnt, uint_t(1));
+    if (remote_cnt > 0) {
+        RemoteSetup setup;
+        setup.N = N;
+        setup.customers = instance->getCustomers().size();
+        setup.p = instance->get_p();
+        setup.n = n;
+        setup.seed_rssv = seed_rssv;
+        setup.is_cap = is_cap;
+        setup.cover_mode = cover_mode;
+        setup.cover_mode_n2 = cover_mode_n2;
+        setup.weighted_obj = instance->get_isWeightedObjFunc();
+        setup.max_ite = MAX_ITE_SUBPROBLEMS;
+        setup.time_limit = TIME_LIMIT_SUBPROBLEMS;
+        setup.method_sp = method_RSSV_sp;
+        setup.type_eval = type_eval_cap;
+        remote_workers = make_unique<RemoteWorkers>();
+        // VNS sub-PMPs do not take the time limit
+        if (TIME_LIMIT_SUBPROBLEMS > 0 && method_RSSV_sp.rfind("VNS", 0) != 0)
+            remote_workers->setReplyTimeout(RSSV_REPLY_FACTOR * TIME_LIMIT_SUBPROBLEMS + RSSV_REPLY_MARGIN);
+        remote_workers->listen(remote_address, remote_cnt, setup);
+    }
+    uint_t pool_cnt = local_thread_cnt + (remote_workers ? remote_workers->size() : 0);
 
+    // all M sub-PMPs go to one pool, a free worker takes the next one
+    auto start_time = tick();
+    auto start_wall = chrono::steady_clock::now();
+    task_times.assign(M + 1, 0);
+    thread_weights.assign(pool_cnt, vector<double>(N, 0));
+    auto& locations = instance->getLocations();
+    auto submit = [&](ThreadPool& pool, uint_t i) {
+        int seed_thread = seed_rssv + i;
+        if (is_cap) {
+            pool.submit([this, seed_thread]() {
+                if (this->solveRemote(seed_thread)) return;
+                this->solveSubproblemTemplate<Solution_cap>(seed_thread, true);
+            });
+        } else {
+            pool.submit([this, seed_thread]() {
+                if (this->solveRemote(seed_thread)) return;
+                this->solveSubproblemTemplate<Solution_std>(seed_thread, false);
+            });
         }
-
-        for (auto &th : threads) {
-            if (th.joinable()) {
-                th.join();
+    };
+    {
+        ThreadPool pool(pool_cnt);
+        if (convergence_window == 0 && !on_provisional) {
+            for (uint_t i = 1; i <= M; ++i) submit(pool, i);
+            pool.wait();
+            M_solved = M;
+        } else {
+            /*
+             * Adaptive sampling: sub-PMPs are solved in windows, after each window the votes
+             * are reduced and the top-n voted locations compared with those of the previous
+             * window. Sampling stops when two windows in a row keep at least
+             * convergence_overlap of the top-n, or after M sub-PMPs.
+             * Pipelined RSSV uses the same windows to hand provisional filtered instances
+             * to the final phase, which then runs while the next window is sampled.
+             */
+            uint_t window = convergence_window > 0 ? convergence_window : (M + provisional_cnt - 1) / provisional_cnt;
+            window = max(window, pool_cnt);
+            auto top_cnt = min(n, N);
+            if (convergence_window > 0) cout << "Convergence check every " << window << " sub-PMPs, top-" << top_cnt << " overlap >= " << convergence_overlap << endl << endl;
+            if (on_provisional) {
+                cout << "Provisional filtered instance every " << window << " sub-PMPs" << endl << endl;
+                prioritized_locations = extractPrioritizedLocations(LOC_PRIORITY_CNT);
+            }
+            vector<double> votes(N, 0);
+            vector<uint_t> top_prev;
+            uint_t stable_cnt = 0;
+            double overlap = 0;
+            M_solved = 0;
+            while (M_solved < M && stable_cnt < 2) {
+                auto last = min(M_solved + window, M);
+                for (uint_t i = M_solved + 1; i <= last; ++i) submit(pool, i);
+                pool.wait();
+                M_solved = last;
+
+                for (auto& local_weights : thread_weights) {
+                    for (uint_t j = 0; j < N; j++) votes[j] += local_weights[j];
+                    fill(local_weights.begin(), local_weights.end(), 0);
+                }
+                auto top = topVotedIndexes(votes, top_cnt);
+                if (!top_prev.empty()) {
+                    uint_t kept = 0;
+                    for (uint_t a = 0, b = 0; a < top.size() && b < top_prev.size();) { // both sorted
+                        if (top[a] == top_prev[b]) {kept++; a++; b++;}
+                        else if (top[a] < top_prev[b]) a++;
+                        else b++;
+                    }
+                    overlap = double(kept) / top_cnt;
+                    if (convergence_window > 0) {
+                        stable_cnt = overlap >= convergence_overlap ? stable_cnt + 1 : 0;
+                        cout << "[INFO] RSSV convergence: " << M_solved << "/" << M << " sub-PMPs, top-" << top_cnt << " overlap " << overlap << endl;
+                    }
+                }
+                top_prev = std::move(top);
+                if (on_provisional && M_solved < M && stable_cnt < 2) on_provisional(buildProvisionalInstance(votes));
+            }
+            for (uint_t j = 0; j < N; j++) thread_weights[0][j] = votes[j];
+            if (convergence_window > 0) {
+                if (M_solved < M) cout << "[INFO] RSSV voting converged after " << M_solved << " of " << M << " sub-PMPs" << endl;
+                else cout << "[INFO] RSSV voting did not converge within " << M << " sub-PMPs (last overlap " << overlap << ")" << endl;
             }
         }
-        threads.clear();
     }
 
+    if (remote_workers) {
+        remote_workers->close();
+        remote_workers.reset();
+    }
+
+    // reduce the voting weights of the workers
+    for (uint_t j = 0; j < N; j++)
+        for (auto& local_weights : thread_weights) weights[locations[j]] += local_weights[j];
+    thread_weights.clear();
+    idx_t kernel_cnt = 0, kernel_size = 0;
+    for (auto& neighbors : kernel_neighbors) {
+        if (neighbors.empty()) continue;
+        kernel_cnt++;
+        kernel_size += neighbors.size();
+    }
+    if (kernel_cnt > 0) cout << "Voting kernel: " << kernel_cnt << " voted locations, avg. " << double(kernel_size) / kernel_cnt << " neighbors inside the kernel support" << endl;
+
     cout << "[INFO] All subproblems solved." << endl << endl;
     tock(start_time);
+    double wall_time = chrono::duration<double>(chrono::steady_clock::now() - start_wall).count();
+    double total_work = 0, max_task = 0;
+    for (uint_t i = 1; i <= M_solved; ++i) {
+        total_work += task_times[i];
+        max_task = max(max_task, task_times[i]);
+    }
+    cout << "Sub-PMP times: total " << total_work << "s, avg " << total_work / M_solved << "s, max " << max_task << "s" << endl;
+    cout << "Wall time " << wall_time << "s, load balance " << (wall_time > 0 ? total_work / (wall_time * pool_cnt) : 1) << endl << endl;
 
-    subSols_avg_dist = subSols_avg_dist / M;
-    subSols_std_dev_dist = subSols_std_dev_dist / M;
+    subSols_avg_dist = subSols_avg_dist / M_solved;
+    subSols_std_dev_dist = subSols_std_dev_dist / M_solved;
     cout << "\nStats: \n";
     cout << "Max dist: " << subSols_max_dist << endl;
     cout << "Min dist: " << subSols_min_dist << endl;
@@ -98,13 +208,14 @@ shared_ptr<Instance> RSSV::run_impl(uint_t thread_cnt, const string& method_sp,
     for (auto fl : filtered_locations) cout << fl << " ";
     cout << endl << endl;
 
-    auto prioritized_locations = extractPrioritizedLocations(LOC_PRIORITY_CNT);
+    if (!on_provisional) prioritized_locations = extractPrioritizedLocations(LOC_PRIORITY_CNT);
     cout << "Extracted " << prioritized_locations.size() << " prioritized locations: ";
     for (auto pl : prioritized_locations) cout << pl << " ";
     cout << endl << endl;
 
-    for (auto fl : filtered_locations) prioritized_locations.insert(fl);
-    vector<uint_t> final_locations(prioritized_locations.begin(), prioritized_locations.end());
+    auto final_set = prioritized_locations;
+    for (auto fl : filtered_locations) final_set.insert(fl);
+    vector<uint_t> final_locations(final_set.begin(), final_set.end());
 
     bool extract_fixed_locations = false;
     if (extract_fixed_locations) {
@@ -136,13 +247,35 @@ void RSSV::solveSubproblemTemplate(int seed, bool isCapacitated) {
     // Use the seed for random number generation
     int thread_id = seed - seed_rssv;
     // std::mt19937 gen(seed);
-    sem.wait(thread_id);
+    auto start_task = chrono::steady_clock::now();
 
     cout << "Solving sub-PMP " << thread_id << "/" << M << "..." << endl;
     auto start = tick();
-    
-    Instance subInstance = instance->sampleSubproblem(n, n, instance->get_p(), seed);
-    subInstance.set_isWeightedObjFunc(instance->get_isWeightedObjFunc());
+
+    SolutionType sol;
+    if (solveSubproblem(seed, isCapacitated, sol)) {
+        if (VERBOSE) cout << "Solution " << seed << ": ";
+        if (VERBOSE) sol.print();
+        processSubsolutionScores(make_shared<SolutionType>(sol));
+        processSubsolutionDists(make_shared<SolutionType>(sol));
+        if (VERBOSE) tock(start);
+        task_times[thread_id] = chrono::duration<double>(chrono::steady_clock::now() - start_task).count();
+        cout << "Sub-PMP " << thread_id << "/" << M << " solved in " << task_times[thread_id] << "s" << endl;
+    } else {
+        cout << "[TIMELIMIT]  Time limit exceeded to solve Sub-cPMPs " << endl;
+    }
+
+}
+
+/*
+ * Sample the sub-PMP of seed and solve it with method_RSSV_sp, false if the time limit is
+ * reached. Shared by the local pool workers and the remote RSSV workers.
+ */
+template <typename SolutionType>
+bool RSSV::solveSubproblem(int seed, bool isCapacitated, SolutionType& sol) {
+    // sub-instance shares the arrays of the orig. instance, only the sampled ids are its own
+    auto subInstance = make_shared<Instance>(instance->sampleSubproblem(n, n, instance->get_p(), seed));
+    subInstance->set_isWeightedObjFunc(instance->get_isWeightedObjFunc());
     
     if (instance->get_p() > n) {
         cout << "[ERROR] The number of facilities is greater than the number of locations to be selected" << endl;
@@ -158,53 +291,137 @@ void RSSV::solveSubproblemTemplate(int seed, bool isCapacitated) {
     
     bool verb = false;
 
-    SolutionType sol;
-    if (checkClock()) {
-        if (method_RSSV_sp == "EXACT_PMP" || (isCapacitated && method_RSSV_sp == "EXACT_CPMP")) {
-            PMP pmp(make_shared<Instance>(subInstance), isCapacitated ? "CPMP" : "PMP");
-            pmp.setCoverModel(cover_mode, instance->getTypeSubarea());
-            pmp.setCoverModel_n2(cover_mode_n2, instance->getTypeSubarea_n2());
-            if (time_limit_subproblem > 0) pmp.setTimeLimit(time_limit_subproblem);
-            if constexpr (std::is_same_v<SolutionType, Solution_std>) {
-                sol = pmp.getSolution_std();
-            } else if constexpr (std::is_same_v<SolutionType, Solution_cap>) {
-                sol = pmp.getSolution_cap();
-            }
-        } else if (method_RSSV_sp == "TB_PMP" || (isCapacitated && method_RSSV_sp == "TB_CPMP")) {
-            TB heuristic(make_shared<Instance>(subInstance), seed);
-            heuristic.setCoverMode(cover_mode);
-            heuristic.setCoverMode_n2(cover_mode_n2);
-            if (time_limit_subproblem > 0) heuristic.setTimeLimit(time_limit_subproblem);
-            if constexpr (std::is_same_v<SolutionType, Solution_std>) {
-                sol = heuristic.run(verb, MAX_ITER_SUBP);
-            } else if constexpr (std::is_same_v<SolutionType, Solution_cap>) {
-                sol = heuristic.run_cap(verb, MAX_ITER_SUBP);
-            }
-        } else if (method_RSSV_sp == "VNS_PMP" || (isCapacitated && method_RSSV_sp == "VNS_CPMP")) {
-            VNS heuristic(make_shared<Instance>(subInstance), seed);
-            heuristic.setCoverMode(cover_mode);
-            heuristic.setCoverMode_n2(cover_mode_n2);
-            // if (time_limit_subproblem > 0) heuristic.setTimeLimit(time_limit_subproblem); // not implemented yet in VNS
-            if constexpr (std::is_same_v<SolutionType, Solution_std>) {
-                sol = heuristic.runVNS_std(verb, MAX_ITER_SUBP);
-            } else if constexpr (std::is_same_v<SolutionType, Solution_cap>) {
-                sol = heuristic.runVNS_cap(method_RSSV_sp, verb, MAX_ITER_SUBP);
-            }
-        } else {
-            cout << "Method to solve the Subproblems: " << method_RSSV_sp << " not found" << endl;
-            exit(1);
+    if (!checkClock()) return false;
+    if (method_RSSV_sp == "EXACT_PMP" || (isCapacitated && method_RSSV_sp == "EXACT_CPMP")) {
+        PMP pmp(subInstance, isCapacitated ? "CPMP" : "PMP");
+        pmp.setCoverModel(cover_mode, instance->getTypeSubarea());
+        pmp.setCoverModel_n2(cover_mode_n2, instance->getTypeSubarea_n2());
+        if (time_limit_subproblem > 0) pmp.setTimeLimit(time_limit_subproblem);
+        if constexpr (std::is_same_v<SolutionType, Solution_std>) {
+            sol = pmp.getSolution_std();
+        } else if constexpr (std::is_same_v<SolutionType, Solution_cap>) {
+            sol = pmp.getSolution_cap();
+        }
+    } else if (method_RSSV_sp == "TB_PMP" || method_RSSV_sp == "TB_PMP_FAST" || (isCapacitated && method_RSSV_sp == "TB_CPMP")) {
+        TB heuristic(subInstance, seed);
+        heuristic.setCoverMode(cover_mode);
+        heuristic.setCoverMode_n2(cover_mode_n2);
+        heuristic.setFastSwap(method_RSSV_sp == "TB_PMP_FAST");
+        heuristic.setTypeEval(type_eval_cap);
+        if (time_limit_subproblem > 0) heuristic.setTimeLimit(time_limit_subproblem);
+        if constexpr (std::is_same_v<SolutionType, Solution_std>) {
+            sol = heuristic.run(verb, MAX_ITER_SUBP);
+        } else if constexpr (std::is_same_v<SolutionType, Solution_cap>) {
+            sol = heuristic.run_cap(verb, MAX_ITER_SUBP);
+        }
+    } else if (method_RSSV_sp == "VNS_PMP" || (isCapacitated && method_RSSV_sp == "VNS_CPMP")) {
+        VNS heuristic(subInstance, seed);
+        heuristic.setCoverMode(cover_mode);
+        heuristic.setCoverMode_n2(cover_mode_n2);
+        heuristic.setTypeEval(type_eval_cap);
+        // if (time_limit_subproblem > 0) heuristic.setTimeLimit(time_limit_subproblem); // not implemented yet in VNS
+        if constexpr (std::is_same_v<SolutionType, Solution_std>) {
+            sol = heuristic.runVNS_std(verb, MAX_ITER_SUBP);
+        } else if constexpr (std::is_same_v<SolutionType, Solution_cap>) {
+            sol = heuristic.runVNS_cap(method_RSSV_sp, verb, MAX_ITER_SUBP);
         }
-
-        if (VERBOSE) cout << "Solution " << seed << ": ";
-        if (VERBOSE) sol.print();
-        processSubsolutionScores(make_shared<SolutionType>(sol));
-        processSubsolutionDists(make_shared<SolutionType>(sol));
-        if (VERBOSE) tock(start);
-        sem.notify(seed);
     } else {
+        cout << "Method to solve the Subproblems: " << method_RSSV_sp << " not found" << endl;
+        exit(1);
+    }
+    return true;
+}
+
+/*
+ * Sub-PMP of seed solved by the remote worker of the calling pool worker, false if the
+ * calling worker is a local one or its remote worker is gone (then it is solved locally).
+ */
+bool RSSV::solveRemote(int seed) {
+    int w = ThreadPool::workerIndex();
+    if (!remote_workers || w < static_cast<int>(local_thread_cnt)) return false;
+    uint_t k = w - local_thread_cnt;
+    int thread_id = seed - seed_rssv;
+
+    RemoteResult result;
+    if (!remote_workers->solve(k, seed, result)) {
+        cout << "[WARN] RSSV worker " << k + 1 << " is gone, solving sub-PMP " << thread_id << " locally" << endl;
+        return false;
+    }
+    if (!result.solved) {
         cout << "[TIMELIMIT]  Time limit exceeded to solve Sub-cPMPs " << endl;
+        return true;
     }
+    for (auto loc_sol : result.p_locations) voteLocation(loc_sol);
+    addSubsolutionDists(result.max_dist, result.min_dist, result.avg_dist, result.std_dev_dist);
+    task_times[thread_id] = result.time;
+    cout << "Sub-PMP " << thread_id << "/" << M << " solved by RSSV worker " << k + 1 << " in " << result.time << "s" << endl;
+    return true;
+}
 
+template <typename SolutionType>
+void RSSV::solveForCoordinator(int seed, RemoteResult& result) {
+    auto start_task = chrono::steady_clock::now();
+    SolutionType sol;
+    result.seed = seed;
+    result.solved = solveSubproblem(seed, std::is_same_v<SolutionType, Solution_cap>, sol);
+    if (result.solved) {
+        sol.statsDistances();
+        result.max_dist = sol.getMaxDist();
+        result.min_dist = sol.getMinDist();
+        result.avg_dist = sol.getAvgDist();
+        result.std_dev_dist = sol.getStdDevDist();
+        auto& p_locations = sol.get_pLocations();
+        result.p_locations.assign(p_locations.begin(), p_locations.end());
+    }
+    result.time = chrono::duration<double>(chrono::steady_clock::now() - start_task).count();
+}
+
+/*
+ * Worker process of a coordinator/worker RSSV: solve the sub-PMPs sent by the coordinator
+ * listening on address until it stops. Returns the exit code of the process.
+ */
+int RSSV::runWorker(const shared_ptr<Instance>& instance, const string& address) {
+    int fd = connectCoordinator(address);
+    if (fd < 0) return 1;
+    RemoteSetup setup;
+    if (!recvSetup(fd, setup)) {
+        cout << "[ERROR] No valid setup from the RSSV coordinator" << endl;
+        closeConnection(fd);
+        return 1;
+    }
+    bool accepted = setup.N == instance->getLocations().size() && setup.customers == instance->getCustomers().size() &&
+                    setup.p == instance->get_p();
+    sendSetupReply(fd, accepted);
+    if (!accepted) {
+        cout << "[ERROR] The RSSV coordinator runs on another instance (N " << setup.N << ", customers " << setup.customers
+             << ", p " << setup.p << ")" << endl;
+        closeConnection(fd);
+        return 1;
+    }
+
+    instance->set_isWeightedObjFunc(setup.weighted_obj);
+    RSSV worker(instance, setup.seed_rssv, setup.n);
+    worker.setCoverMode(setup.cover_mode);
+    worker.setCoverMode_n2(setup.cover_mode_n2);
+    worker.setTypeEval(setup.type_eval);
+    worker.setMAX_ITE_SUBPROBLEMS(setup.max_ite);
+    worker.setTIME_LIMIT_SUBPROBLEMS(setup.time_limit);
+    worker.method_RSSV_sp = setup.method_sp;
+    cout << "[INFO] RSSV worker connected to " << address << ": " << setup.method_sp << " sub-PMPs of size " << setup.n << endl;
+
+    int seed;
+    uint_t solved_cnt = 0;
+    while (recvTask(fd, seed)) {
+        RemoteResult result;
+        if (setup.is_cap) worker.solveForCoordinator<Solution_cap>(seed, result);
+        else worker.solveForCoordinator<Solution_std>(seed, result);
+        if (!sendResult(fd, result)) break;
+        solved_cnt++;
+        cout << "Sub-PMP " << seed - setup.seed_rssv << " solved in " << result.time << "s" << endl;
+    }
+    closeConnection(fd);
+    cout << "[INFO] RSSV worker done, " << solved_cnt << " sub-PMPs solved" << endl;
+    return 0;
 }
 
 /*
@@ -213,32 +430,46 @@ void RSSV::solveSubproblemTemplate(int seed, bool isCapacitated) {
  */
 template <typename SolutionType>
 void RSSV::processSubsolutionScores(shared_ptr<SolutionType> solution) {
-    for (auto loc_sol : solution->get_pLocations()) {
-        // get closest customer in orig. instance
-        auto cust_cl = instance->getClosestCust(loc_sol);
-        // evaluate voting score increment for all locations in orig. instance
-        weights_mutex.lock();
-        for (auto loc : instance->getLocations()) {
-            if (loc == loc_sol) {
-                weights[loc] += 1;
-            } else {
-                // weights[loc] += instance->getVotingScore(loc, cust_cl);
-                weights[loc] += instance->getVotingScore(loc, loc_sol);
-            }
+    for (auto loc_sol : solution->get_pLocations()) voteLocation(loc_sol);
+}
+
+void RSSV::voteLocation(uint_t loc_sol) {
+    // weights of the calling pool worker, no lock needed
+    auto& local_weights = thread_weights[max(ThreadPool::workerIndex(), 0)];
+    // only locations inside the kernel support get a nonzero score
+    for (auto& neighbor : getKernelNeighbors(loc_sol)) local_weights[neighbor.first] += neighbor.second;
+}
+
+/*
+ * Locations of the orig. instance with a nonzero voting score from loc_sol, i.e. within
+ * BW_CUTOFF * h, with their score (1 for loc_sol itself). Built by the first sub-PMP voting
+ * for loc_sol and reused by all later ones.
+ */
+const vector<pair<uint_t, double>>& RSSV::getKernelNeighbors(uint_t loc_sol) {
+    static const vector<pair<uint_t, double>> no_neighbors;
+    auto it = loc_index.find(loc_sol);
+    if (it == loc_index.end()) return no_neighbors;
+    auto s = it->second;
+    call_once(kernel_built[s], [&]() {
+        auto& locations = instance->getLocations();
+        auto& neighbors = kernel_neighbors[s];
+        for (uint_t j = 0; j < N; j++) {
+            // weights[loc] += instance->getVotingScore(loc, cust_cl);
+            double score = locations[j] == loc_sol ? 1 : instance->getVotingScore(locations[j], loc_sol);
+            if (score > 0) neighbors.emplace_back(j, score);
         }
-        weights_mutex.unlock();
-    }
+        neighbors.shrink_to_fit();
+    });
+    return kernel_neighbors[s];
 }
 
 template <typename SolutionType>
 void RSSV::processSubsolutionDists(shared_ptr<SolutionType> solution) {
     solution->statsDistances();
-    dist_t max_dist_local = solution->getMaxDist();
-    dist_t min_dist_local = solution->getMinDist();
-    dist_t avg_dist_local = solution->getAvgDist();
-    dist_t std_dev_dist_local = solution->getStdDevDist();
-    
+    addSubsolutionDists(solution->getMaxDist(), solution->getMinDist(), solution->getAvgDist(), solution->getStdDevDist());
+}
 
+void RSSV::addSubsolutionDists(dist_t max_dist_local, dist_t min_dist_local, dist_t avg_dist_local, dist_t std_dev_dist_local) {
     dist_mutex.lock();
     subSols_max_dist = max(subSols_max_dist, max_dist_local);
     subSols_min_dist = min(subSols_min_dist, min_dist_local);
@@ -252,6 +483,41 @@ bool cmp(pair<uint_t, double>& a,
          pair<uint_t, double>& b){
     return a.second < b.second;
 }
+// indexes (in instance->getLocations()) of the cnt highest votes, sorted by index; ties go to the lower index
+vector<uint_t> RSSV::topVotedIndexes(const vector<double>& votes, uint_t cnt) {
+    vector<uint_t> order(votes.size());
+    for (uint_t j = 0; j < order.size(); j++) order[j] = j;
+    cnt = min(cnt, static_cast<uint_t>(order.size()));
+    nth_element(order.begin(), order.begin() + cnt, order.end(), [&votes](uint_t a, uint_t b) {
+        return votes[a] > votes[b] || (votes[a] == votes[b] && a < b);
+    });
+    order.resize(cnt);
+    sort(order.begin(), order.end());
+    return order;
+}
+
+/*
+ * Filtered instance from the votes of the sub-PMPs solved so far: the top-n voted and the
+ * prioritized locations, as the final one but without its logging and statistics.
+ */
+shared_ptr<Instance> RSSV::buildProvisionalInstance(const vector<double>& votes) {
+    auto& locations = instance->getLocations();
+    auto top = topVotedIndexes(votes, min(n, N));
+    vector<uint_t> voted_locs;
+    voted_locs.reserve(top.size());
+    for (auto j : top) voted_locs.push_back(locations[j]);
+    auto candidates = prioritized_locations;
+    candidates.insert(voted_locs.begin(), voted_locs.end());
+    auto provisional = make_shared<Instance>(instance->getReducedSubproblem(vector<uint_t>(candidates.begin(), candidates.end()), instance->getTypeService()));
+    provisional->setVotedLocs(voted_locs);
+    if (add_threshold_dist) {
+        dist_mutex.lock();
+        provisional->set_ThresholdDist(subSols_max_dist);
+        dist_mutex.unlock();
+    }
+    return provisional;
+}
+
 /*
  * Filter locations for the final filtered instance.
  * First cnt(=n) locations with the highest weight are extracted.
@@ -409,4 +675,12 @@ void RSSV::setTIME_LIMIT_SUBPROBLEMS(dist_t time_limit) {
 }
 void RSSV::setMAX_ITE_SUBPROBLEMS(uint_t max_ite) {
     MAX_ITE_SUBPROBLEMS = max_ite;
+}
+void RSSV::setConvergence(uint_t window, double overlap) {
+    convergence_window = window;
+    convergence_overlap = overlap;
+}
+void RSSV::setProvisionalCallback(uint_t cnt, function<void(shared_ptr<Instance>)> callback) {
+    provisional_cnt = max(cnt, uint_t(1));
+    on_provisional = std::move(callback);
 }
\ No newline at end of file
@@ -11,10 +11,13 @@
 #include "instance.hpp"
 #include "instance.hpp"
 #include "solution_std.hpp"
-#include "semaphore.hpp"
+#include "thread_pool.hpp"
+#include "rssv_remote.hpp"
 
 using namespace std;
 
+#define RSSV_PROVISIONAL_CNT 10 // provisional filtered instances published by a pipelined RSSV
+
 class RSSV {
 private:
     shared_ptr<Instance> instance; // original PMP instance
@@ -22,11 +25,20 @@ private:
     int seed_rssv;
     uint_t N; // original PMP size (no. of locations)
     uint_t M; // no. of sub-PMPs
+    uint_t M_solved = 0; // no. of sub-PMPs actually solved (< M after convergence)
+    uint_t convergence_window = 0; // > 0: stop sampling once the top-n ranking is stable over windows of this many sub-PMPs
+    double convergence_overlap = 0.95; // share of the top-n kept from one window to the next to call it stable
+    uint_t provisional_cnt = 0; // > 0: publish about this many provisional filtered instances while sampling
+    function<void(shared_ptr<Instance>)> on_provisional; // receives the provisional filtered instances (pipelined RSSV)
+    unordered_set<uint_t> prioritized_locations; // extractPrioritizedLocations(LOC_PRIORITY_CNT), kept when pipelined
     uint_t n; // sub-PMP size
-    Semaphore sem;
-    mutex weights_mutex;
+    vector<double> task_times; // sub-PMP index -> solve time (s)
     mutex dist_mutex;
     unordered_map<uint_t, double> weights; // spatial voting weights of N original locations
+    vector<vector<double>> thread_weights; // pool worker -> voting weights indexed like instance->getLocations(), reduced into weights
+    unordered_map<uint_t, uint_t> loc_index; // original location -> index in instance->getLocations()
+    vector<vector<pair<uint_t, double>>> kernel_neighbors; // location index -> (location index, voting score) inside BW_CUTOFF * h
+    unique_ptr<once_flag[]> kernel_built; // location index -> kernel_neighbors filled
     // vector<uint_t> filtered_locs; // locations that are filtered 
     string method_RSSV_sp;
     int DEFAULT_MAX_NUM_ITER = 10000000;
@@ -41,6 +53,16 @@ private:
 
     uint_t MAX_ITE_SUBPROBLEMS = 0;
     dist_t TIME_LIMIT_SUBPROBLEMS = 0;
+    string type_eval_cap = "GAP"; // evaluation of swaps in capacitated sub-PMPs
+
+    string remote_address; // coordinator/worker RSSV: address the coordinator listens on
+    uint_t remote_cnt = 0; // remote RSSV workers to wait for (0: local threads only)
+    unique_ptr<RemoteWorkers> remote_workers;
+    uint_t local_thread_cnt = 1; // pool workers below this index solve locally, the others forward to remote_workers
+
+    bool solveRemote(int seed);
+    template <typename SolutionType>
+    void solveForCoordinator(int seed, RemoteResult& result);
 
 
 public:
@@ -51,14 +73,27 @@ public:
     template <typename SolutionType>
     void solveSubproblemTemplate(int seed, bool isCapacitated);
     template <typename SolutionType>
+    bool solveSubproblem(int seed, bool isCapacitated, SolutionType& sol);
+    static int runWorker(const shared_ptr<Instance>& instance, const string& address);
+    template <typename SolutionType>
     void processSubsolutionScores(shared_ptr<SolutionType> solution);
     template <typename SolutionType>
     void processSubsolutionDists(shared_ptr<SolutionType> solution);
+    void voteLocation(uint_t loc_sol);
+    void addSubsolutionDists(dist_t max_dist_local, dist_t min_dist_local, dist_t avg_dist_local, dist_t std_dev_dist_local);
+    const vector<pair<uint_t, double>>& getKernelNeighbors(uint_t loc_sol);
+    vector<uint_t> topVotedIndexes(const vector<double>& votes, uint_t cnt);
+    shared_ptr<Instance> buildProvisionalInstance(const vector<double>& votes);
     vector<uint_t> filterLocations(uint_t cnt);
     unordered_set<uint_t> extractPrioritizedLocations(uint_t min_cnt);
     vector<uint_t> extractFixedLocations(vector<uint_t> vet_locs);
     void setTIME_LIMIT_SUBPROBLEMS(dist_t time_limit);
     void setMAX_ITE_SUBPROBLEMS(uint_t max_ite);
+    void setConvergence(uint_t window, double overlap);
+    void setProvisionalCallback(uint_t cnt, function<void(shared_ptr<Instance>)> callback);
+    uint_t getNumSubproblemsSolved() const {
+        return M_solved;
+    }
 
 
     void setCoverMode(bool mode) {
@@ -70,6 +105,13 @@ public:
     void setAddThresholdDist(bool add_threshold) {
         add_threshold_dist = add_threshold;
     }
+    void setTypeEval(const string& type_eval) {
+        type_eval_cap = type_eval;
+    }
+    void setRemoteWorkers(const string& address, uint_t cnt) {
+        remote_address = address;
+        remote_cnt = cnt;
+    }
 };
 
 #endif //LARGE_PMP_RSSV_HPP
\ No newline at end of file
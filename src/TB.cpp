@@ -55,7 +55,7 @@ void writeReport_TB(const string& filename, dist_t objective, int num_ite, int n
 
 
 
-TB::TB(shared_ptr<Instance> instance, uint_t seed):instance(std::move(instance)) {
+TB::TB(shared_ptr<Instance> instance, uint_t seed):instance(std::move(instance)), solutions_map(this->instance) {
     engine.seed(seed);
 //    cout << "TB heuristic initialized\n";
 //    instance->print();
@@ -167,7 +167,7 @@ Solution_cap TB::initRandomCapSolution() {
         auto loc = locations[loc_id];
         p_locations.insert(loc);
     }
-    Solution_cap sol(instance, p_locations,"GAPrelax",cover_mode);
+    Solution_cap sol(instance, p_locations,typeEvalRelax(),cover_mode);
     // sol.setCoverMode(cover_mode);
     return sol;
 }
@@ -192,7 +192,7 @@ Solution_cap TB::initHighestCapSolution() {
         p_locations.insert(sorted_locations[i].second);
     }
 
-    Solution_cap solut(instance, p_locations);
+    Solution_cap solut(instance, p_locations, typeEvalRelax());
     // solut.setCoverMode(cover_mode);
     return solut;
 }
@@ -228,7 +228,7 @@ Solution_cap TB::initSmartRandomCapSolution(){
         p_locations.insert(loc);
     }
 
-    Solution_cap solut(instance, p_locations, "GAPrelax",cover_mode);
+    Solution_cap solut(instance, p_locations, typeEvalRelax(),cover_mode);
     bool feasible = solut.getFeasibility();
     while(!feasible){
         
@@ -239,7 +239,7 @@ Solution_cap TB::initSmartRandomCapSolution(){
             }
             sort(sorted_p_locations.begin(), sorted_p_locations.end());
             if (sorted_p_locations[0].second != sorted_locations[0].second){
-                solut.replaceLocation(sorted_p_locations[0].second, sorted_locations[0].second, "GAPrelax");
+                solut.replaceLocation(sorted_p_locations[0].second, sorted_locations[0].second, typeEvalRelax());
                 if (!sorted_locations.empty()) {sorted_locations.erase(sorted_locations.begin());}
                 feasible = solut.getFeasibility();
             }
@@ -326,7 +326,7 @@ Solution_cap TB::initHighestCapSolution_Cover() {
     // for (auto loc:p_locations) cout << loc << " ";
     // cout << "\n";
 
-    Solution_cap solut(instance, p_locations);
+    Solution_cap solut(instance, p_locations, typeEvalRelax());
     solut.setCoverMode(cover_mode);
     solut.setCoverMode_n2(cover_mode_n2);
     return solut;
@@ -439,7 +439,8 @@ Solution_std TB::run(bool verbose, int MAX_ITE) {
     sol_best.setCoverMode_n2(cover_mode_n2);
     sol_best.print();
 
-    sol_best = localSearch_std(sol_best, verbose, MAX_ITE);
+    if (fast_swap) sol_best = localSearch_std_fast(sol_best, verbose, MAX_ITE);
+    else sol_best = localSearch_std(sol_best, verbose, MAX_ITE);
 
     return sol_best;
 }
@@ -456,6 +457,24 @@ Solution_cap TB::run_cap(bool verbose, int MAX_ITE) {
     return sol_best;
 }
 
+// local search warm-started from p_locations (e.g. the incumbent on a refreshed instance)
+Solution_std TB::runFrom(const unordered_set<uint_t>& p_locations, bool verbose, int MAX_ITE) {
+    if (p_locations.size() != instance->get_p()) return run(verbose, MAX_ITE);
+
+    Solution_std sol_best(instance, p_locations);
+    sol_best.setCoverMode(cover_mode);
+    sol_best.setCoverMode_n2(cover_mode_n2);
+    if (fast_swap) return localSearch_std_fast(sol_best, verbose, MAX_ITE);
+    return localSearch_std(sol_best, verbose, MAX_ITE);
+}
+
+Solution_cap TB::runFrom_cap(const unordered_set<uint_t>& p_locations, bool verbose, int MAX_ITE) {
+    if (p_locations.size() != instance->get_p()) return run_cap(verbose, MAX_ITE);
+
+    Solution_cap sol_best(instance, p_locations, type_eval_solution, cover_mode);
+    return localSearch_cap(sol_best, verbose, MAX_ITE);
+}
+
 Solution_std TB::localSearch_std(Solution_std sol_best, bool verbose, int MAX_ITE) {
 
     
@@ -473,7 +492,6 @@ Solution_std TB::localSearch_std(Solution_std sol_best, bool verbose, int MAX_IT
     while (improved && ite < MAX_ITE) {
 
         improved = false;
-        sol_cand = sol_best;
 
         auto p_locations = sol_best.get_pLocations();
 
@@ -485,25 +503,30 @@ Solution_std TB::localSearch_std(Solution_std sol_best, bool verbose, int MAX_IT
 
         // Locations Swaps
         for (auto loc: locations_not_in_p) { // First improvement over locations
+            dist_t best_delta = 0;
+            uint_t best_p_loc = numeric_limits<uint_t>::max();
             for (auto p_loc:p_locations) { // Best improvement over p_locations
-                Solution_std sol_tmp = sol_best; // N1 for sol_best
 
-                if (test_Cover(sol_tmp.get_pLocations(), p_loc, loc) &&
-                    test_CoverN2(sol_tmp.get_pLocations(), p_loc, loc) &&
-                    test_SizeofP(sol_tmp.get_pLocations(), p_loc, loc)) {
+                if (test_Cover(p_locations, p_loc, loc) &&
+                    test_CoverN2(p_locations, p_loc, loc) &&
+                    test_SizeofP(p_locations, p_loc, loc)) {
 
-                    sol_tmp.replaceLocation(p_loc, loc);
-                    
-                    if (sol_cand.get_objective() - sol_tmp.get_objective() > TOLERANCE_OBJ) { 
-                        sol_cand = sol_tmp;
+                    auto delta = sol_best.swapDelta(p_loc, loc); // N1 for sol_best, evaluated in place
+                    if (best_delta - delta > TOLERANCE_OBJ) { 
+                        best_delta = delta;
+                        best_p_loc = p_loc;
                         improved = true;
                     }
 
                 }
 
-                if (checkClock_TB(start_time_total, time_limit_seconds)) {
-                    if (sol_cand.isSolutionFeasible() == true && sol_cand.get_objective() < sol_best.get_objective()) {
-                        sol_best = sol_cand;
+                if (checkClock_TB(start_time_total, time_limit_seconds, external_time)) {
+                    if (improved) {
+                        sol_cand = sol_best;
+                        sol_cand.replaceLocation(best_p_loc, loc);
+                        if (sol_cand.isSolutionFeasible() == true && sol_cand.get_objective() < sol_best.get_objective()) {
+                            sol_best = sol_cand;
+                        }
                     }
                     // if (verbose) printSolution_TB(sol_best, get_cpu_time_TB() - start_time_total);
                     cout << "Num ite total uncapacited TB: " << ite << "\n";
@@ -516,7 +539,7 @@ Solution_std TB::localSearch_std(Solution_std sol_best, bool verbose, int MAX_IT
             } 
             if (improved) {
 
-                sol_best = sol_cand;
+                sol_best.replaceLocation(best_p_loc, loc);
                 if (verbose) {
                     cout << "\n[INFO] Improved TB solution: \n"; 
                     if (verbose) printSolution_TB(sol_best, get_cpu_time_TB() - start_time_total);
@@ -538,6 +561,130 @@ Solution_std TB::localSearch_std(Solution_std sol_best, bool verbose, int MAX_IT
     return sol_best;
 }
 
+/*
+ * Swap-based local search in the style of Resende and Werneck (2003).
+ * For the current solution every customer u contributes, through its closest (d1) and
+ * second-closest (d2) open location, to three accumulators:
+ *   loss[i]     += d2 - d1                      for i = closest(u)
+ *   gain[j]     += max(0, d1 - d(u,j))          for every location j
+ *   extra[i][j] += d2 - max(d(u,j), d1)         for i = closest(u) and d(u,j) < d2
+ * so that the profit of swapping i out and j in is gain[j] - loss[i] + extra[i][j], and
+ * all p*(m-p) swaps are priced in one sweep. After a swap only the customers whose
+ * closest/second-closest distances changed are removed from and re-added to the
+ * accumulators. extra is dense (p x m), rows are indexed by the slot of the open location.
+ */
+Solution_std TB::localSearch_std_fast(Solution_std sol_best, bool verbose, int MAX_ITE) {
+
+    if (instance->get_p() < 2) return localSearch_std(sol_best, verbose, MAX_ITE); // d2 undefined
+
+    cout << "[INFO] Uncapacitated fast swap local search started\n";
+
+    auto time_limit_seconds = time_limit;
+    const auto& locations = instance->getLocations();
+    const auto& customers = instance->getCustomers();
+    uint_t m = locations.size();
+    uint_t p = instance->get_p();
+    auto start_time_total = get_cpu_time_TB();
+
+    // locations are handled by their index k in getLocations(), customers by their index i
+    // slot of each open location (row of extra), max for closed locations
+    vector<uint_t> slot_of(m, numeric_limits<uint_t>::max());
+    vector<uint_t> slot_loc;
+    for (auto p_loc : sol_best.get_pLocations()) {
+        auto k = instance->getLocIndex(p_loc);
+        slot_of[k] = slot_loc.size();
+        slot_loc.push_back(k);
+    }
+
+    vector<dist_t> gain(m, 0), loss(p, 0), extra(static_cast<size_t>(p) * m, 0);
+    // closest location index and distances each customer is currently accounted with
+    vector<uint_t> cust_closest(customers.size());
+    vector<dist_t> cust_d1(customers.size()), cust_d2(customers.size());
+
+    auto addCustomer = [&](uint_t i, dist_t sign) {
+        uint_t s = slot_of[cust_closest[i]];
+        dist_t d1 = cust_d1[i], d2 = cust_d2[i];
+        loss[s] += sign * (d2 - d1);
+        dist_t* extra_row = &extra[static_cast<size_t>(s) * m];
+        for (uint_t k = 0; k < m; k++) {
+            auto dist = sol_best.evalDistByIdx(locations[k], k, i);
+            if (dist < d1) gain[k] += sign * (d1 - dist);
+            if (dist < d2) extra_row[k] += sign * (d2 - max(dist, d1));
+        }
+    };
+    auto syncCustomer = [&](uint_t i) {
+        cust_closest[i] = instance->getLocIndex(sol_best.getClosestLocs()[i]); // changed customers only
+        cust_d1[i] = sol_best.getClosestDists()[i];
+        cust_d2[i] = sol_best.getSecondDists()[i];
+    };
+
+    for (uint_t i = 0; i < customers.size(); i++) {
+        syncCustomer(i);
+        addCustomer(i, 1);
+    }
+
+    int ite = 1;
+    while (ite < MAX_ITE) {
+
+        // Best improvement over all swaps
+        dist_t best_profit = TOLERANCE_OBJ;
+        uint_t best_s = numeric_limits<uint_t>::max(), best_k = numeric_limits<uint_t>::max();
+        for (uint_t s = 0; s < p; s++) {
+            const dist_t* extra_row = &extra[static_cast<size_t>(s) * m];
+            for (uint_t k = 0; k < m; k++) {
+                if (slot_of[k] != numeric_limits<uint_t>::max()) continue;
+                dist_t profit = gain[k] - loss[s] + extra_row[k];
+                if (profit > best_profit &&
+                    test_Cover(sol_best.get_pLocations(), locations[slot_loc[s]], locations[k]) &&
+                    test_CoverN2(sol_best.get_pLocations(), locations[slot_loc[s]], locations[k]) &&
+                    test_SizeofP(sol_best.get_pLocations(), locations[slot_loc[s]], locations[k])) {
+                    best_profit = profit;
+                    best_s = s;
+                    best_k = k;
+                }
+            }
+        }
+        if (best_s == numeric_limits<uint_t>::max()) break;
+
+        // Apply the swap; the new location takes the slot of the removed one
+        uint_t k_out = slot_loc[best_s];
+        sol_best.replaceLocation(locations[k_out], locations[best_k]);
+
+        vector<uint_t> changed;
+        for (uint_t i = 0; i < customers.size(); i++) {
+            if (cust_closest[i] == k_out ||
+                sol_best.getClosestLocs()[i] != locations[cust_closest[i]] ||
+                sol_best.getClosestDists()[i] != cust_d1[i] ||
+                sol_best.getSecondDists()[i] != cust_d2[i]) {
+                addCustomer(i, -1);
+                changed.push_back(i);
+            }
+        }
+        slot_of[k_out] = numeric_limits<uint_t>::max();
+        slot_of[best_k] = best_s;
+        slot_loc[best_s] = best_k;
+        for (auto i : changed) {
+            syncCustomer(i);
+            addCustomer(i, 1);
+        }
+
+        if (verbose) {
+            cout << "\n[INFO] Improved TB solution: \n";
+            printSolution_TB(sol_best, get_cpu_time_TB() - start_time_total);
+            cout << endl;
+        }
+        ite++;
+
+        if (checkClock_TB(start_time_total, time_limit_seconds, external_time)) break;
+    }
+    if (ite == MAX_ITE) cout << "TB reached max iterations\n";
+
+    cout << "Num ite total uncapacited TB: " << ite << "\n";
+    if(sol_best.isSolutionFeasible() == false){cout << "tb solution is not feasible\n";}
+    else{cout << "tb solution is feasible\n";}
+    return sol_best;
+}
+
 bool TB::test_Capacity(Solution_cap sol, uint_t in_p, uint_t out_p) {
     // test if the new solution is feasible
     if (instance->getLocCapacity(out_p) <= 1) return false;
@@ -545,18 +692,17 @@ bool TB::test_Capacity(Solution_cap sol, uint_t in_p, uint_t out_p) {
     return true;
 }
 
-int TB::isSolutionExistsinMap(Solution_cap sol, uint_t in_p, uint_t out_p) {
-    // test if solution already exists in map
-    unordered_set<uint_t> p_locations_test = sol.get_pLocations();
-    p_locations_test.erase(in_p);
-    p_locations_test.insert(out_p);
-    
-    int index = solutions_map.pSetExists_index(p_locations_test);
-    if (index != -1){
-        return index;
-    }else{
-        return -1;
-    }
+const Solution_cap* TB::isSolutionExistsinMap(const Solution_cap& sol, uint64_t p_key, uint_t in_p, uint_t out_p) {
+    // test if solution already exists in map, p_key is the fingerprint of sol
+    return solutions_map.findSwap(p_key, sol.get_pLocations(), in_p, out_p);
+}
+
+// a search on this instance already evaluated the swap to nothing better than objective
+bool TB::isKnownWorse(const EvalCache::PSetKey& key, dist_t objective) {
+    if (eval_cache == nullptr) return false;
+    EvalCache::Entry entry;
+    if (!eval_cache->lookup(key, type_eval_solution, entry)) return false;
+    return !entry.feasible || entry.objective >= objective + TOLERANCE_OBJ;
 }
 
 bool  TB::test_LB_PMP(Solution_cap sol, uint_t in_p, uint_t out_p) {
@@ -658,6 +804,25 @@ Solution_cap TB::localSearch_cap(Solution_cap sol_best, bool verbose, int MAX_IT
     int ite = 1;
     auto start_time_total = get_cpu_time_TB();
 
+    // swaps are evaluated on one CPLEX model per scan thread, built when first needed and re-solved with new y bounds
+    bool is_gap = strcmp(type_eval_solution, "GAP") == 0;
+    bool use_gap_model = is_gap || strcmp(type_eval_solution, "GAPrelax") == 0;
+    gap_models.resize(max(thread_cnt, uint_t(1)));
+    for (auto& model : gap_models)
+        if (!use_gap_model || (model != nullptr && model->is_BinModel != is_gap)) model = nullptr;
+
+    // the swaps of a block of locations are evaluated in parallel, then accepted in scan order
+    unique_ptr<ThreadPool> pool;
+    if (thread_cnt > 1) pool = make_unique<ThreadPool>(thread_cnt);
+
+    enum SwapState { SWAP_SKIPPED, SWAP_STORED, SWAP_EVALUATED };
+    struct SwapEval {
+        uint_t loc;
+        uint_t p_loc;
+        SwapState state;
+        Solution_cap sol;
+    };
+
     if (generate_reports)
         writeReport_TB(report_filename, sol_best.get_objective(), 0, solutions_map.getNumSolutions(), external_time);
 
@@ -666,61 +831,99 @@ Solution_cap TB::localSearch_cap(Solution_cap sol_best, bool verbose, int MAX_IT
         improved = false;
         sol_cand = sol_best;
         auto p_locations = sol_best.get_pLocations();
+        auto p_key = EvalCache::PSetKey::of(p_locations);
+        vector<uint_t> p_order(p_locations.begin(), p_locations.end());
 
         vector<uint_t> locations_not_in_p;
         for (auto loc : locations) 
             if (find(p_locations.begin(), p_locations.end(), loc) == p_locations.end())                 // loc is not in p_locations, so add it to locations_not_in_p
                 locations_not_in_p.push_back(loc);
 
-        auto start_time = get_cpu_time_TB();
-        for (auto loc:locations_not_in_p) { // First improvement over locations
-            // #pragma omp parallel for 
-            for (auto p_loc:p_locations) { // Best improvement over p_locations
-                Solution_cap sol_tmp = sol_best;    // N1 for sol_best
-
-                if (test_basic_Solution_cap(sol_tmp, p_loc, loc)){ 
-                    int index = isSolutionExistsinMap(sol_tmp, p_loc, loc);
-                    if (index != -1){
-                        if(solutions_map.getObjectiveByIndex(index)  < sol_cand.get_objective()){
-                            sol_cand = solutions_map.getSolution(index);
-                            improved = true;
-                        }
-                    }else if (test_LB_PMP(sol_tmp,p_loc,loc)) { // LB1 
-                    // else if (test_LB_PMP(sol_tmp,p_loc,loc) && test_UB_heur(sol_tmp, p_loc, loc)) { // LB1 and UB1
-                        
-                        sol_tmp.add_UpperBound(sol_best.get_objective());
-                        sol_tmp.replaceLocation(p_loc, loc, "GAP"); if(sol_tmp.isSolutionFeasible()) solutions_map.addUniqueSolution(sol_tmp);
-                        // sol_tmp.replaceLocation(p_loc, loc, "heuristic");
-
-                        auto elapsed_time_total = (get_cpu_time_TB() - start_time_total) + external_time;
-                        // #pragma omp critical
-                        if (sol_tmp.get_objective() < sol_cand.get_objective() + TOLERANCE_OBJ) { // LB2
-                
-                            if (verbose) {
-                                cout << "Improved solution (TB): \n"; cout << "Interation: " << ite << "\n";
-                                printSolution_TB(sol_tmp, (get_cpu_time_TB() - start_time) + external_time); cout << endl;
-                            }
-                            sol_cand = copySolution_cap(sol_tmp, 0);
-                            improved = true;
-                            cout << "Improved solution (TB): \n"; cout << "Interation: " << ite << "\n";
-                            sol_cand.print();
+        // runs on the scan threads: reads sol_best and the instance, writes only its own swap;
+        // slot is the evaluator of the calling thread (its index in this TB's pool, 0 without one)
+        auto evalSwap = [&](SwapEval& swap, size_t slot) {
+            auto& gap_model = gap_models[slot];
+            if (use_gap_model && gap_model == nullptr) gap_model = make_shared<PMP>(instance, "GAP", is_gap);
+            Solution_cap sol_tmp = sol_best;    // N1 for sol_best
+            sol_tmp.setGAPModel(gap_model);
+
+            if (!test_basic_Solution_cap(sol_tmp, swap.p_loc, swap.loc)) {swap.state = SWAP_SKIPPED; return;}
+            if (swap.state == SWAP_STORED) return;
+            // else if (test_LB_PMP(sol_tmp,p_loc,loc) && test_UB_heur(sol_tmp, p_loc, loc)) { // LB1 and UB1
+            if (!test_LB_PMP(sol_tmp, swap.p_loc, swap.loc) || isKnownWorse(p_key.swap(swap.p_loc, swap.loc), sol_best.get_objective())) {swap.state = SWAP_SKIPPED; return;} // LB1
+
+            sol_tmp.add_UpperBound(sol_best.get_objective());
+            sol_tmp.replaceLocation(swap.p_loc, swap.loc, type_eval_solution);
+            // sol_tmp was cut by sol_best, only a feasible evaluation is a property of its p-set
+            if (eval_cache != nullptr && sol_tmp.isSolutionFeasible()) eval_cache->store(p_key.swap(swap.p_loc, swap.loc), type_eval_solution, sol_tmp.get_objective(), true);
+            swap.sol = std::move(sol_tmp);
+            swap.state = SWAP_EVALUATED;
+        };
+
+        // enough swaps per block to keep every thread busy, a single location when sequential
+        size_t block_locs = thread_cnt > 1 ? max(size_t(1), (2 * thread_cnt + p_order.size() - 1) / max(p_order.size(), size_t(1))) : 1;
 
-                            if (generate_reports) writeReport_TB(report_filename, sol_cand.get_objective(), ite, solutions_map.getNumSolutions(),elapsed_time_total);
+        auto start_time = get_cpu_time_TB();
+        for (size_t first = 0; first < locations_not_in_p.size() && !improved; first += block_locs) {
+            size_t last = min(first + block_locs, locations_not_in_p.size());
+
+            // stored solutions are looked up here, Solution_MAP is only used by this thread
+            vector<SwapEval> swaps;
+            swaps.reserve((last - first) * p_order.size());
+            for (size_t l = first; l < last; l++) {
+                for (auto p_loc : p_order) {
+                    SwapEval swap{locations_not_in_p[l], p_loc, SWAP_SKIPPED, Solution_cap()};
+                    auto sol_stored = isSolutionExistsinMap(sol_best, p_key.x, p_loc, swap.loc);
+                    if (sol_stored != nullptr) {swap.state = SWAP_STORED; swap.sol = *sol_stored;}
+                    swaps.push_back(std::move(swap));
+                }
+            }
+            if (pool) {
+                for (auto& swap : swaps) pool->submit([&evalSwap, &swap]() { evalSwap(swap, ThreadPool::workerIndex()); });
+                pool->wait();
+            } else {
+                // workerIndex() may belong to the pool of a caller (RSSV, parallel VNS), not to this TB
+                for (auto& swap : swaps) evalSwap(swap, 0);
+            }
 
+            for (size_t k = 0; k < swaps.size(); k++) { // First improvement over locations, best improvement over p_locations
+                auto& swap = swaps[k];
+                if (swap.state == SWAP_STORED) {
+                    if(swap.sol.get_objective()  < sol_cand.get_objective()){
+                        sol_cand = swap.sol;
+                        improved = true;
+                    }
+                } else if (swap.state == SWAP_EVALUATED) {
+                    auto& sol_tmp = swap.sol;
+                    if(sol_tmp.isSolutionFeasible()) solutions_map.addUniqueSolution(sol_tmp, Solution_MAP::swapFingerprint(p_key.x, swap.p_loc, swap.loc));
+
+                    auto elapsed_time_total = (get_cpu_time_TB() - start_time_total) + external_time;
+                    if (sol_tmp.get_objective() < sol_cand.get_objective() + TOLERANCE_OBJ) { // LB2
+            
+                        if (verbose) {
+                            cout << "Improved solution (TB): \n"; cout << "Interation: " << ite << "\n";
+                            printSolution_TB(sol_tmp, (get_cpu_time_TB() - start_time) + external_time); cout << endl;
                         }
+                        sol_cand = copySolution_cap(sol_tmp, 0);
+                        improved = true;
+                        cout << "Improved solution (TB): \n"; cout << "Interation: " << ite << "\n";
+                        sol_cand.print();
 
-                        // check time limit
-                        if (checkClock_TB(start_time_total, time_limit_seconds, external_time)) {
-                            if(sol_cand.isSolutionFeasible() && sol_cand.get_objective() < sol_best.get_objective()){sol_best = copySolution_cap(sol_cand);}
-                            return sol_best;
-                            // break;  
-                        }
+                        if (generate_reports) writeReport_TB(report_filename, sol_cand.get_objective(), ite, solutions_map.getNumSolutions(),elapsed_time_total);
 
                     }
+
+                    // check time limit
+                    if (checkClock_TB(start_time_total, time_limit_seconds, external_time)) {
+                        if(sol_cand.isSolutionFeasible() && sol_cand.get_objective() < sol_best.get_objective()){sol_best = copySolution_cap(sol_cand);}
+                        return sol_best;
+                        // break;  
+                    }
                 }
-            }
-            auto elapsed_time_total = (get_cpu_time_TB() - start_time_total) + external_time;
-            if (improved) {
+
+                // end of the swaps of one location, the rest of the block is dropped after an improvement
+                if ((k + 1) % p_order.size() != 0 || !improved) continue;
+                auto elapsed_time_total = (get_cpu_time_TB() - start_time_total) + external_time;
 
                 sol_best = copySolution_cap(sol_cand, 0);
                 sol_best.print();
@@ -760,6 +963,14 @@ void TB::setSolutionMap(Solution_MAP sol_map) {
     this->solutions_map = sol_map;
 }
 
+void TB::setThreadCount(uint_t thread_cnt) {
+    this->thread_cnt = max(thread_cnt, uint_t(1));
+}
+
+void TB::setEvalCache(shared_ptr<EvalCache> eval_cache) {
+    this->eval_cache = std::move(eval_cache);
+}
+
 void TB::setGenerateReports(bool generate_reports) {
     this->generate_reports = generate_reports;
 }
@@ -768,6 +979,24 @@ void TB::setMethod(string Method) {
     this->typeMethod = Method;
 }
 
+void TB::setTypeEval(const string& type_eval) {
+    // kept as literals, Solution_cap stores the pointer
+    if (type_eval == "GAP") this->type_eval_solution = "GAP";
+    else if (type_eval == "GAPrelax") this->type_eval_solution = "GAPrelax";
+    else if (type_eval == "TRANSPORT") this->type_eval_solution = "TRANSPORT";
+    else if (type_eval == "heuristic") this->type_eval_solution = "heuristic";
+    else cerr << "[ERROR] typeEval " << type_eval << " not recognized, using " << type_eval_solution << endl;
+}
+
+// Evaluation of the continuous GAP for initial solutions
+const char* TB::typeEvalRelax() const {
+    if (strcmp(type_eval_solution, "TRANSPORT") == 0) return "TRANSPORT";
+    return "GAPrelax";
+}
+
+void TB::setFastSwap(bool fast_swap) {
+    this->fast_swap = fast_swap;
+}
 void TB::setExternalTime(double time) {
     this->external_time = time;
 }
@@ -11,6 +11,8 @@
 #include "solution_std.hpp"
 #include "solution_cap.hpp"
 #include "solution_map.hpp"
+#include "eval_cache.hpp"
+#include "thread_pool.hpp"
 #include "globals.hpp"
 #include "utils.hpp"
 #include "PMP.hpp"
@@ -22,13 +24,19 @@ class TB {
 private:
     shared_ptr<Instance> instance;
     default_random_engine engine;
-    string type_eval_solution;
+    const char* type_eval_solution="GAP"; // evaluation of swaps in localSearch_cap
     bool generate_reports=false;
     string typeMethod="TB";
     double external_time=0;
     bool cover_mode=false;
     bool cover_mode_n2=false;
     double time_limit=CLOCK_LIMIT;
+    bool fast_swap=false; // gain/loss/extra swap evaluation (TB_PMP_FAST)
+    uint_t thread_cnt=1; // threads of the capacitated swap scan
+    vector<shared_ptr<PMP>> gap_models; // GAP evaluator per scan thread, built once and re-solved for every swap
+    shared_ptr<EvalCache> eval_cache; // objectives shared with the other searches on this instance
+    bool isKnownWorse(const EvalCache::PSetKey& key, dist_t objective);
+    const char* typeEvalRelax() const;
 public:
     explicit TB(shared_ptr<Instance> instance, uint_t seed);
     Solution_std initRandomSolution();
@@ -42,11 +50,14 @@ public:
 
     Solution_std run(bool verbose, int MAX_ITE);
     Solution_cap run_cap(bool verbose, int MAX_ITE);
+    Solution_std runFrom(const unordered_set<uint_t>& p_locations, bool verbose, int MAX_ITE);
+    Solution_cap runFrom_cap(const unordered_set<uint_t>& p_locations, bool verbose, int MAX_ITE);
     Solution_std localSearch_std(Solution_std sol_best, bool verbose, int MAX_ITE);
+    Solution_std localSearch_std_fast(Solution_std sol_best, bool verbose, int MAX_ITE);
     Solution_cap localSearch_cap(Solution_cap sol_best, bool verbose, int MAX_ITE);
     Solution_cap localSearch_cap_cover(Solution_cap sol_best, bool verbose, int MAX_ITE);
     // bool isBetterSolution(Solution_cap sol, uint_t in_p, uint_t out_p);   
-    int isSolutionExistsinMap(Solution_cap sol, uint_t in_p, uint_t out_p);
+    const Solution_cap* isSolutionExistsinMap(const Solution_cap& sol, uint64_t p_key, uint_t in_p, uint_t out_p);
     bool test_Capacity(Solution_cap sol, uint_t in_p, uint_t out_p);
     bool test_LB_PMP(Solution_cap sol, uint_t in_p, uint_t out_p);
     bool test_UB_heur(Solution_cap sol, uint_t in_p, uint_t out_p);
@@ -57,12 +68,16 @@ public:
     Solution_cap copySolution_cap(Solution_cap sol, bool createGAPeval=0);
     Solution_MAP solutions_map;
     void setSolutionMap(Solution_MAP sol_map);
+    void setEvalCache(shared_ptr<EvalCache> eval_cache);
     void setGenerateReports(bool generate_reports);
     void setMethod(string Method);
     void setExternalTime(double time);
     void setCoverMode(bool cover_mode);
     void setCoverMode_n2(bool cover_mode_n2);
     void setTimeLimit(double time_limit);
+    void setFastSwap(bool fast_swap);
+    void setThreadCount(uint_t thread_cnt);
+    void setTypeEval(const string& type_eval);
 };
 
 
@@ -509,6 +509,134 @@ SolutionType runVNS(SolutionType sol_current, bool verbose, int MAX_ITE, int MAX
 
 
 
+Solution_std VNS::shake(const Solution_std& sol_current, unsigned int num_swaps, int seed){
+    if (cover_mode) return rand_swap_Locations_cover(sol_current, num_swaps, seed);
+    return rand_swap_Locations(sol_current, num_swaps, seed);
+}
+
+Solution_cap VNS::shake(const Solution_cap& sol_current, unsigned int num_swaps, int seed){
+    if (cover_mode) return rand_swap_Locations_cap_cover(sol_current, num_swaps, seed);
+    return rand_swap_Locations_cap(sol_current, num_swaps, seed);
+}
+
+void writeReport(const string& filename, dist_t objective, int num_ite, int num_solutions, double time);
+
+static Solution_std localSearchTB(TB& tb, const Solution_std& sol){
+    return tb.localSearch_std(sol, true, DEFAULT_MAX_ITE);
+}
+
+static Solution_cap localSearchTB(TB& tb, const Solution_cap& sol){
+    return tb.localSearch_cap(sol, true, DEFAULT_MAX_ITE);
+}
+
+/*
+ * Parallel VNS: thread_cnt workers run the shake -> TB local search -> accept loop, each
+ * with its own TB, neighborhood k and copy of the incumbent. The global best is published
+ * through an atomic pointer (compare-and-swap, no lock): a worker that improves on it
+ * swaps in its solution, and every worker restarts from it (k = 2) as soon as it sees a
+ * better one at the start of an iteration. Published solutions are never modified and
+ * are only freed after all workers finished. The iterations (and the shake seeds) are
+ * numbered globally, so MAX_ITE and the time limit bound the whole search.
+ */
+template<typename SolutionType>
+SolutionType VNS::runParallel(const function<TB(uint_t)>& makeTB, SolutionType sol_best, bool verbose, int MAX_ITE,
+                              double start_time_total, double time_limit_seconds, const string& report_filename) {
+
+    struct Incumbent {
+        SolutionType sol;
+        dist_t objective;
+    };
+
+    cout << "\n[INFO] Parallel VNS with " << thread_cnt << " workers\n";
+    auto Kmax = static_cast<unsigned int>(instance->get_p()/2); // max number of locations to swap
+
+    vector<vector<unique_ptr<Incumbent>>> published(thread_cnt); // worker -> solutions it published
+    unique_ptr<Incumbent> initial(new Incumbent{sol_best, sol_best.get_objective()});
+    atomic<Incumbent*> incumbent(initial.get());
+    atomic<int> next_ite(1);
+    atomic<int> num_improvements(0);
+    atomic<bool> stop(false);
+    mutex report_mtx;
+
+    vector<uint_t> seeds(thread_cnt);
+    for (auto& seed : seeds) seed = engine();
+
+    {
+        ThreadPool pool(thread_cnt);
+        for (uint_t t = 0; t < thread_cnt; t++) {
+            pool.submit([&, t]() {
+                TB tb = makeTB(seeds[t]);
+                SolutionType sol_local = sol_best;
+                unsigned int k = 2; // initial neighborhood
+
+                while (!stop) {
+                    int ite = next_ite++;
+                    if (ite > MAX_ITE) break;
+
+                    // synchronize with the shared incumbent
+                    auto best = incumbent.load();
+                    if (best->objective < sol_local.get_objective()) {
+                        sol_local = best->sol;
+                        k = 2;
+                    }
+
+                    auto new_sol = shake(sol_local, k, ite);
+                    tb.setExternalTime(get_cpu_time_VNS() - start_time_total);
+                    new_sol = localSearchTB(tb, new_sol);
+                    auto elapsed_time_total = get_cpu_time_VNS() - start_time_total;
+
+                    if (new_sol.get_objective() < sol_local.get_objective()) {
+                        sol_local = new_sol;
+                        k = 2;
+
+                        published[t].emplace_back(new Incumbent{sol_local, sol_local.get_objective()});
+                        auto node = published[t].back().get();
+                        auto current = incumbent.load();
+                        while (node->objective < current->objective && !incumbent.compare_exchange_weak(current, node)) {}
+                        if (node->objective < current->objective) { // swapped in
+                            num_improvements++;
+                            if (verbose) {
+                                lock_guard<mutex> lock(report_mtx);
+                                cout << "\n[INFO] Improved global solution in VNS (worker " << t << "): \n";
+                                node->sol.print();
+                                cout << "Num ite VNS: " << ite << "\n";
+                                cout << "elapsed time total: " << elapsed_time_total << " seconds\n";
+                            }
+                            if (!report_filename.empty()) {
+                                lock_guard<mutex> lock(report_mtx);
+                                writeReport(report_filename, node->objective, ite, tb.solutions_map.getNumSolutions(), elapsed_time_total);
+                            }
+                        } else {
+                            published[t].pop_back(); // another worker published a better one meanwhile
+                        }
+                    } else if (k <= Kmax) {
+                        k++;
+                    } else {
+                        k = 2;
+                    }
+
+                    if (elapsed_time_total >= time_limit_seconds) {
+                        stop = true;
+                        cout << "\n[INFO] Time limit reached. Stopping the VNS worker " << t << ".\n";
+                    }
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    sol_best = incumbent.load()->sol;
+    auto elapsed_time = get_cpu_time_VNS() - start_time_total;
+    cout << "\n[INFO] Final solution VNS: \n";
+    sol_best.print();
+    cout << "\n";
+    cout << "Elapsed time: " << elapsed_time << " seconds\n";
+    cout << "Num ite VNS: " << min(next_ite.load(), MAX_ITE + 1) - 1 << "\n";
+    cout << "Improvements of the shared incumbent: " << num_improvements << "\n";
+    cout << "-----------------------------------------------------------------\n";
+    return sol_best;
+}
+
 Solution_std VNS::runVNS_std(bool verbose, int MAX_ITE) {
 
     cout << "\n[INFO] Uncapacitated VNS heuristic started\n";
@@ -525,12 +653,16 @@ Solution_std VNS::runVNS_std(bool verbose, int MAX_ITE) {
     cout << "Time Limit: " << time_limit_seconds << " seconds\n";
     if (cover_mode) cout << "Cover Mode: ON " << "\n";
 
-    TB tb(instance, engine());
-    tb.setCoverMode(cover_mode);
-    tb.setSolutionMap(solutions_map);
-    // tb.setMethod("TB_" + Method);
-    tb.setMethod("TB_");
-    tb.setGenerateReports(true);
+    auto makeTB = [this](uint_t seed) {
+        TB tb(instance, seed);
+        tb.setCoverMode(cover_mode);
+        tb.setSolutionMap(solutions_map);
+        // tb.setMethod("TB_" + Method);
+        tb.setMethod("TB_");
+        tb.setGenerateReports(true);
+        return tb;
+    };
+    TB tb = makeTB(engine());
     
     Solution_std sol_best;
     if (cover_mode) sol_best = tb.initRandomSolution_Cover();
@@ -579,6 +711,7 @@ Solution_std VNS::runVNS_std(bool verbose, int MAX_ITE) {
         return sol_best;
     }
 
+    if (thread_cnt > 1) return runParallel(makeTB, sol_best, verbose, MAX_ITE, start_time_total, time_limit_seconds, "");
 
     int ite = 1;
     while (ite <= MAX_ITE) {
@@ -723,18 +856,25 @@ Solution_cap VNS::runVNS_cap(const string& Method, bool verbose, int MAX_ITE) {
     cout << "Time Limit: " << time_limit_seconds << " seconds\n";
     if (cover_mode) cout << "Cover Mode: ON " << "\n";
 
-    TB tb(instance, engine());
-    tb.setCoverMode(cover_mode);
-    tb.setCoverMode_n2(cover_mode_n2);
-    tb.setSolutionMap(solutions_map);
-    tb.setMethod("TB_" + Method);
-    tb.setGenerateReports(true);
+    auto makeTB = [this, &Method](uint_t seed) {
+        TB tb(instance, seed);
+        tb.setCoverMode(cover_mode);
+        tb.setCoverMode_n2(cover_mode_n2);
+        tb.setSolutionMap(solutions_map);
+        tb.setMethod("TB_" + Method);
+        tb.setTypeEval(type_eval_cap);
+        tb.setEvalCache(eval_cache);
+        tb.setGenerateReports(true);
+        return tb;
+    };
+    TB tb = makeTB(engine());
 
     Solution_cap sol_best;
     // sol_best = tb.fixedCapSolution();
     if (cover_mode) sol_best = tb.initHighestCapSolution_Cover();
     // initial solution add cover n2
     // else sol_best = tb.initHighestCapSolution();
+    else if (initial_solution.get_pLocations().empty()) sol_best = tb.initHighestCapSolution(); // no setInitialSolution
     else sol_best = initial_solution;
 
 
@@ -787,7 +927,7 @@ Solution_cap VNS::runVNS_cap(const string& Method, bool verbose, int MAX_ITE) {
         return sol_best;
     }
 
-
+    if (thread_cnt > 1) return runParallel(makeTB, sol_best, verbose, MAX_ITE, start_time_total, time_limit_seconds, generate_reports ? report_filename : "");
 
     int ite = 1;
     while (ite <= MAX_ITE) {
@@ -899,10 +1039,22 @@ void VNS::setSolutionMap(Solution_MAP sol_map){
     solutions_map = sol_map;
 }
 
+void VNS::setEvalCache(shared_ptr<EvalCache> eval_cache){
+    this->eval_cache = std::move(eval_cache);
+}
+
+void VNS::setThreadCount(uint_t thread_cnt){
+    this->thread_cnt = max(thread_cnt, uint_t(1));
+}
+
 void VNS::setMethod(string Method){
     this->typeMethod = Method;
 }
 
+void VNS::setTypeEval(const string& type_eval){
+    this->type_eval_cap = type_eval;
+}
+
 void VNS::setCoverMode(bool cover_mode){
     this->cover_mode = cover_mode;
 }
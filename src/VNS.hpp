@@ -6,6 +6,8 @@
 #include <string>
 #include <sys/time.h>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 
 #include "instance.hpp"
 #include "solution_std.hpp"
@@ -27,7 +29,16 @@ private:
     bool cover_mode_n2=false;   
     double external_time=0;
     bool useInitSol=false;
+    string type_eval_cap="GAP"; // evaluation of swaps in the TB local search
     Solution_cap initial_solution;
+    shared_ptr<EvalCache> eval_cache; // handed to the TB local search
+    uint_t thread_cnt=1; // VNS workers sharing the incumbent
+
+    Solution_std shake(const Solution_std& sol_current, unsigned int num_swaps, int seed);
+    Solution_cap shake(const Solution_cap& sol_current, unsigned int num_swaps, int seed);
+    template<typename SolutionType>
+    SolutionType runParallel(const function<TB(uint_t)>& makeTB, SolutionType sol_best, bool verbose, int MAX_ITE,
+                             double start_time_total, double time_limit_seconds, const string& report_filename);
 public:
     explicit VNS(shared_ptr<Instance> instance, uint_t seed);
 
@@ -53,8 +64,11 @@ public:
     // Solution_cap runVNS_cap(bool verbose, int MAX_ITE, int MAX_TIME);
     Solution_MAP solutions_map;
     void setSolutionMap(Solution_MAP sol_map);
+    void setEvalCache(shared_ptr<EvalCache> eval_cache);
+    void setThreadCount(uint_t thread_cnt);
     void setGenerateReports(bool generate_reports);
     void setMethod(string Method);
+    void setTypeEval(const string& type_eval);
     void setCoverMode(bool cover_mode);
     void setCoverMode_n2(bool cover_mode_n2);
     void setExternalTime(double time);
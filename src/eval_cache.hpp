@@ -0,0 +1,139 @@
+#ifndef LARGE_PMP_EVAL_CACHE_HPP
+#define LARGE_PMP_EVAL_CACHE_HPP
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "globals.hpp"
+#include "solution_map.hpp"
+
+#define EVAL_CACHE_SHARDS 64
+#define EVAL_CACHE_MAX_SIZE 1000000 // evaluations kept over all shards
+
+/*
+ * Objective of evaluated p-sets, shared by every search running on the same instance
+ * (TB/VNS workers hold a shared_ptr to it). Unlike Solution_MAP it stores no assignment,
+ * only what is needed to skip an expensive evaluation (GAP, GAPrelax, TRANSPORT) of a
+ * swap that another search has already evaluated.
+ * A p-set is keyed by two order-independent fingerprints that a swap updates in O(1):
+ * the XOR of the Solution_MAP location keys (picks the shard and the bucket) and the sum
+ * of a second key per location (checked on a hit). Each shard has its own mutex, and
+ * drops its oldest entries once it holds its part of max_size.
+ */
+class EvalCache {
+public:
+    struct PSetKey {
+        uint64_t x = 0; // Solution_MAP::fingerprint
+        uint64_t s = 0;
+
+        static PSetKey of(const unordered_set<uint_t>& p_locations) {
+            PSetKey key;
+            for (auto loc : p_locations) {
+                key.x ^= Solution_MAP::locationKey(loc);
+                key.s += sumKey(loc);
+            }
+            return key;
+        }
+
+        // key of the p-set after closing loc_old and opening loc_new
+        PSetKey swap(uint_t loc_old, uint_t loc_new) const {
+            PSetKey key;
+            key.x = Solution_MAP::swapFingerprint(x, loc_old, loc_new);
+            key.s = s - sumKey(loc_old) + sumKey(loc_new);
+            return key;
+        }
+    };
+
+    struct Entry {
+        dist_t objective;
+        bool feasible;
+    };
+
+    explicit EvalCache(size_t max_size = EVAL_CACHE_MAX_SIZE) {
+        shard_size = max(max_size / EVAL_CACHE_SHARDS, size_t(1));
+    }
+
+    EvalCache(const EvalCache&) = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+
+    bool lookup(const PSetKey& key, const char* type_eval, Entry& entry) {
+        auto type = typeKey(type_eval);
+        auto& shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.entries.find(key.x ^ type);
+        if (it == shard.entries.end() || it->second.s != key.s || it->second.type != type) {
+            misses++;
+            return false;
+        }
+        entry = it->second.entry;
+        hits++;
+        return true;
+    }
+
+    /*
+     * Only store evaluations that depend on the p-set alone: an evaluation cut by an
+     * upper bound is infeasible because of the bound, not because of the p-set.
+     */
+    void store(const PSetKey& key, const char* type_eval, dist_t objective, bool feasible) {
+        auto type = typeKey(type_eval);
+        auto& shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto inserted = shard.entries.emplace(key.x ^ type, Stored{key.s, type, Entry{objective, feasible}});
+        if (!inserted.second) {
+            inserted.first->second = Stored{key.s, type, Entry{objective, feasible}};
+            return;
+        }
+        shard.order.push_back(key.x ^ type);
+        while (shard.order.size() > shard_size) {
+            shard.entries.erase(shard.order.front());
+            shard.order.pop_front();
+        }
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+
+    uint64_t getHits() const { return hits; }
+    uint64_t getMisses() const { return misses; }
+
+private:
+    struct Stored {
+        uint64_t s;
+        uint64_t type;
+        Entry entry;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<uint64_t, Stored> entries;
+        std::deque<uint64_t> order; // insertion order, oldest first
+    };
+
+    Shard shards[EVAL_CACHE_SHARDS];
+    size_t shard_size;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    static uint64_t sumKey(uint_t loc) {
+        return Solution_MAP::locationKey(loc ^ 0x5bd1e995u) * 0x2545F4914F6CDD1DULL;
+    }
+
+    static uint64_t typeKey(const char* type_eval) {
+        return Solution_MAP::locationKey(static_cast<uint_t>(std::hash<std::string>{}(type_eval)));
+    }
+
+    static size_t shardOf(const PSetKey& key) {
+        return key.x >> 58; // top 6 bits, EVAL_CACHE_SHARDS = 64
+    }
+};
+
+#endif //LARGE_PMP_EVAL_CACHE_HPP
@@ -18,4 +18,7 @@ bool VERBOSE = false;
 uint_t TOLERANCE_CPT = 10;
 uint_t K = 50;
 uint_t PERCENTAGE = 50;
-uint_t UB_MAX_ITER = 10000000;
\ No newline at end of file
+uint_t UB_MAX_ITER = 10000000;
+#ifdef DIST_FIXED_POINT
+double DIST_SCALE = DIST_FIXED_SCALE;
+#endif
\ No newline at end of file
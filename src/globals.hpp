@@ -8,12 +8,33 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
 
 using namespace std;
 
 typedef unsigned int uint_t;
 typedef double dist_t;
+typedef uint64_t idx_t; // index in the distance storage, (loc_max+1)*(cust_max+1) does not fit in 32 bits
+
+// element type of the stored distances (build option DIST_STORAGE), objectives stay in dist_t;
+// fixed point stores round(dist * DIST_SCALE), the largest value stands for DEFAULT_DISTANCE
+#if defined(DIST_STORAGE_FLOAT)
+typedef float dist_store_t;
+#elif defined(DIST_STORAGE_FIXED16)
+typedef uint16_t dist_store_t;
+#elif defined(DIST_STORAGE_FIXED32)
+typedef uint32_t dist_store_t;
+#else
+typedef double dist_store_t;
+#endif
+#if defined(DIST_STORAGE_FIXED16) || defined(DIST_STORAGE_FIXED32)
+#define DIST_FIXED_POINT
+#ifndef DIST_FIXED_SCALE
+#define DIST_FIXED_SCALE 100
+#endif
+extern double DIST_SCALE; // steps per distance unit: DIST_FIXED_SCALE, lowered if the max distance of the instance does not fit
+#endif
 typedef struct {uint_t node;
                 dist_t dist;
                 } my_pair;
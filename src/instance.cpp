@@ -3,25 +3,87 @@
 #include <utility>
 #include <sstream>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <charconv>
+#include <thread>
+
+/*
+ * Binary instance file (large_PMP convert), all sections 8-byte aligned:
+ *   header | locations[num_locations] | customers[num_customers] (uint_t)
+ *   | cust_weights[cust_max_id+1] | loc_capacities[loc_max_id+1] (dist_t)
+ *   | dist_matrix[(loc_max_id+1)*(cust_max_id+1)] (dist_store_t, getDistIndex layout)
+ */
+#define BINARY_MAGIC "LPMPBIN"
+#define BINARY_VERSION 3
+struct BinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dist_bytes;    // sizeof(dist_store_t)
+    double dist_scale;      // DIST_SCALE of the stored codes for fixed point, 0 for float/double
+    uint32_t loc_max_id;
+    uint32_t cust_max_id;
+    uint64_t num_locations;
+    uint64_t num_customers;
+    uint64_t total_demand;
+    uint64_t dist_cnt;      // bandwidth statistics of the distances read
+    double dist_sum;
+    double dist_sum_sq;
+};
+
+static idx_t alignBinary(idx_t offset) {
+    return (offset + 7) & ~idx_t(7);
+}
+
+static double binaryDistScale() {
+#ifdef DIST_FIXED_POINT
+    return DIST_SCALE;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Fixed point: keep DIST_FIXED_SCALE unless max_dist would not fit in the codes below the
+ * DEFAULT_DISTANCE one, then lower the scale so that it does (coarser distances, reported).
+ * Float/double storage: nothing to do.
+ */
+void Instance::fitDistScale(dist_t max_dist) {
+#ifdef DIST_FIXED_POINT
+    const dist_t max_code = numeric_limits<dist_store_t>::max() - 1;
+    DIST_SCALE = DIST_FIXED_SCALE;
+    if (max_dist * DIST_SCALE > max_code) {
+        DIST_SCALE = max_code / max_dist;
+        cout << "[WARN] Max distance " << max_dist << " does not fit in " << sizeof(dist_store_t) * 8 << "-bit fixed point at scale "
+             << DIST_FIXED_SCALE << ", scale lowered to " << DIST_SCALE << " (distances rounded to " << 1 / DIST_SCALE << ")" << endl;
+    }
+#else
+    (void)max_dist;
+#endif
+}
 
 
 Instance::Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights,
-                   shared_ptr<dist_t[]> loc_capacities, shared_ptr<dist_t[]> dist_matrix, uint_t p,
-                   uint_t loc_max, uint_t cust_max, string type_service)
-        : locations(locations), customers(customers), cust_weights(cust_weights),
-          loc_capacities(loc_capacities),dist_matrix(dist_matrix),
+                   shared_ptr<dist_t[]> loc_capacities, shared_ptr<dist_store_t[]> dist_matrix, uint_t p,
+                   uint_t loc_max, uint_t cust_max, string type_service, shared_ptr<SparseDist> sparse_dists, bool compact_index)
+        : locations(std::move(locations)), customers(std::move(customers)), cust_weights(cust_weights),
+          loc_capacities(loc_capacities),dist_matrix(dist_matrix),sparse_dists(sparse_dists),
           p(p),loc_max_id(loc_max), cust_max_id(cust_max), type_service(type_service){
     total_demand = 0;
     for (auto cust:this->customers) {
         total_demand += this->getCustWeight(cust);
     }
+    this->compact_index = compact_index;
+    buildIndexTables();
 }
 
 Instance::Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights,
-                   shared_ptr<dist_t[]> loc_capacities, shared_ptr<dist_t[]> dist_matrix, uint_t p,
-                   uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea)
-        : locations(locations), customers(customers), cust_weights(cust_weights),
-          loc_capacities(loc_capacities),dist_matrix(dist_matrix),
+                   shared_ptr<dist_t[]> loc_capacities, shared_ptr<dist_store_t[]> dist_matrix, uint_t p,
+                   uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea, shared_ptr<SparseDist> sparse_dists, bool compact_index)
+        : locations(std::move(locations)), customers(std::move(customers)), cust_weights(cust_weights),
+          loc_capacities(loc_capacities),dist_matrix(dist_matrix),sparse_dists(sparse_dists),
           p(p),loc_max_id(loc_max), cust_max_id(cust_max), type_service(type_service), 
           unique_subareas(unique_subareas), loc_coverages(loc_coverages), type_subarea(type_subarea){
     cover_mode = true;
@@ -29,14 +91,16 @@ Instance::Instance(vector<uint_t> locations, vector<uint_t> customers, shared_pt
     for (auto cust:this->customers) {
         total_demand += this->getCustWeight(cust);
     }
+    this->compact_index = compact_index;
+    buildIndexTables();
     this->cover_max_id = unique_subareas.size();
 }
 
 Instance::Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights,
-                   shared_ptr<dist_t[]> loc_capacities, shared_ptr<dist_t[]> dist_matrix, uint_t p,
-                   uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea, unordered_set<uint_t> unique_subareas_n2, shared_ptr<uint_t[]> loc_coverages_n2, string type_subarea_n2)
-        : locations(locations), customers(customers), cust_weights(cust_weights),
-          loc_capacities(loc_capacities),dist_matrix(dist_matrix),
+                   shared_ptr<dist_t[]> loc_capacities, shared_ptr<dist_store_t[]> dist_matrix, uint_t p,
+                   uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea, unordered_set<uint_t> unique_subareas_n2, shared_ptr<uint_t[]> loc_coverages_n2, string type_subarea_n2, shared_ptr<SparseDist> sparse_dists, bool compact_index)
+        : locations(std::move(locations)), customers(std::move(customers)), cust_weights(cust_weights),
+          loc_capacities(loc_capacities),dist_matrix(dist_matrix),sparse_dists(sparse_dists),
           p(p),loc_max_id(loc_max), cust_max_id(cust_max), type_service(type_service), 
           unique_subareas(unique_subareas), loc_coverages(loc_coverages), type_subarea(type_subarea),
           unique_subareas_n2(unique_subareas_n2), loc_coverages_n2(loc_coverages_n2), type_subarea_n2(type_subarea_n2){
@@ -46,11 +110,201 @@ Instance::Instance(vector<uint_t> locations, vector<uint_t> customers, shared_pt
     for (auto cust:this->customers) {
         total_demand += this->getCustWeight(cust);
     }
+    this->compact_index = compact_index;
+    buildIndexTables();
     this->cover_max_id = unique_subareas.size();
     this->cover_n2_max_id = unique_subareas_n2.size();
     cout << "type subarea n2: " << type_subarea_n2 << endl;
 }
 
+// text distance matrix mapped in memory, split in byte ranges cut at line ends
+struct DistFile {
+    const char* data = nullptr;
+    idx_t length = 0;
+    vector<const char*> bounds; // range t is [bounds[t], bounds[t+1])
+};
+
+// Parse one field of a line; skips leading separators and the rest of the field (e.g. ".0" of an id)
+template <typename T>
+static bool parseField(const char*& ptr, const char* end, char delim, T& value) {
+    auto isSeparator = [delim](char c) {return c == delim || c == ' ' || c == '\t' || c == '\r';};
+    while (ptr < end && isSeparator(*ptr)) ptr++;
+    auto res = from_chars(ptr, end, value);
+    if (res.ec != errc()) return false;
+    ptr = res.ptr;
+    while (ptr < end && !isSeparator(*ptr)) ptr++;
+    return true;
+}
+
+// Call f(cust, loc, ptr, eol) for each line of a range, ptr is after the loc field
+template <typename F>
+static void forEachDistLine(const char* begin, const char* end, char delim, F f) {
+    for (auto ptr = begin; ptr < end;) {
+        auto eol = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+        if (eol == nullptr) eol = end;
+        uint_t cust, loc;
+        if (parseField(ptr, eol, delim, cust) && parseField(ptr, eol, delim, loc)) f(cust, loc, ptr, eol);
+        ptr = eol + 1;
+    }
+}
+
+/*
+ * Map the text distance matrix "cust loc dist" (first line skipped) and split it into
+ * thread_cnt byte ranges, each read by its own thread with from_chars.
+ */
+static DistFile mapDistFile(const string& filename, uint_t thread_cnt) {
+    DistFile file;
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        cerr << "Error while trying to open the distance matrix " << filename << endl;
+        exit(-1);
+    }
+    file.length = st.st_size;
+    if (file.length == 0) {
+        close(fd);
+        file.bounds.assign(thread_cnt + 1, nullptr);
+        return file;
+    }
+    void* base = mmap(nullptr, file.length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        cerr << "Error while trying to map the distance matrix " << filename << endl;
+        exit(-1);
+    }
+    madvise(base, file.length, MADV_SEQUENTIAL);
+    file.data = static_cast<const char*>(base);
+    auto end = file.data + file.length;
+
+    auto first = static_cast<const char*>(memchr(file.data, '\n', file.length)); // skip first line
+    first = (first == nullptr) ? end : first + 1;
+
+    file.bounds.assign(thread_cnt + 1, end);
+    file.bounds[0] = first;
+    for (uint_t t = 1; t < thread_cnt; t++) {
+        auto cut = max(file.bounds[t - 1], first + (end - first) * t / thread_cnt);
+        auto eol = (cut < end) ? static_cast<const char*>(memchr(cut, '\n', end - cut)) : nullptr;
+        file.bounds[t] = (eol == nullptr) ? end : eol + 1;
+    }
+    return file;
+}
+
+static void unmapDistFile(DistFile& file) {
+    if (file.data != nullptr) munmap(const_cast<char*>(file.data), file.length);
+    file.data = nullptr;
+}
+
+// First pass: only the max ids to size the storage, and the max distance for fixed point storage
+static void scanDistIds(const DistFile& file, char delim, uint_t& cust_max_id, uint_t& loc_max_id, dist_t& max_dist) {
+    uint_t thread_cnt = file.bounds.size() - 1;
+    vector<uint_t> cust_max(thread_cnt, 0), loc_max(thread_cnt, 0);
+    vector<dist_t> dist_max(thread_cnt, 0);
+#ifdef DIST_FIXED_POINT
+    const bool scan_dists = true;
+#else
+    const bool scan_dists = false;
+#endif
+    vector<thread> threads;
+    for (uint_t t = 0; t < thread_cnt; t++) {
+        threads.emplace_back([&, t]() {
+            forEachDistLine(file.bounds[t], file.bounds[t + 1], delim, [&](uint_t cust, uint_t loc, const char* ptr, const char* eol) {
+                cust_max[t] = max(cust_max[t], cust);
+                loc_max[t] = max(loc_max[t], loc);
+                dist_t dist;
+                if (scan_dists && parseField(ptr, eol, delim, dist) && dist < DEFAULT_DISTANCE) dist_max[t] = max(dist_max[t], dist);
+            });
+        });
+    }
+    for (auto& th:threads) th.join();
+    for (uint_t t = 0; t < thread_cnt; t++) {
+        cust_max_id = max(cust_max_id, cust_max[t]);
+        loc_max_id = max(loc_max_id, loc_max[t]);
+        max_dist = max(max_dist, dist_max[t]);
+    }
+}
+
+/*
+ * Second pass: each thread fills the storage from its byte range. The dense matrix is
+ * written in place; in sparse mode every thread keeps its own candidate heaps, merged
+ * per customer range at the end, so nothing is buffered per pair. The distance sums
+ * are merged across threads for calculate_Bandwidth.
+ */
+void Instance::fillDistMatrix(const DistFile& file, char delim, dist_t& sum, dist_t& sum_sq, uint_t& cnt) {
+    idx_t size = idx_t(loc_max_id + 1) * (cust_max_id + 1);
+    uint_t thread_cnt = file.bounds.size() - 1;
+    vector<vector<char>> loc_flags(thread_cnt), cust_flags(thread_cnt);
+    vector<dist_t> sums(thread_cnt, 0), sums_sq(thread_cnt, 0);
+    vector<uint_t> cnts(thread_cnt, 0);
+
+    bool sparse = (knn_k > 0 || knn_cutoff > 0);
+    vector<vector<vector<pair<dist_t, uint_t>>>> thread_heaps(sparse ? thread_cnt : 0);
+    if (sparse) {
+        cand_heaps.assign(cust_max_id + 1, {});
+    } else {
+        dist_matrix = shared_ptr<dist_store_t[]>(new dist_store_t[size], std::default_delete<dist_store_t[]>());
+    }
+
+    auto fillRange = [&](uint_t t) {
+        if (!sparse) for (idx_t i = size * t / thread_cnt; i < size * (t + 1) / thread_cnt; i++) dist_matrix[i] = encodeDist(DEFAULT_DISTANCE);
+    };
+    auto fillLines = [&](uint_t t) {
+        loc_flags[t].assign(loc_max_id + 1, 0);
+        cust_flags[t].assign(cust_max_id + 1, 0);
+        if (sparse) thread_heaps[t].resize(cust_max_id + 1);
+        forEachDistLine(file.bounds[t], file.bounds[t + 1], delim, [&](uint_t cust, uint_t loc, const char* ptr, const char* eol) {
+            dist_t dist;
+            if (!parseField(ptr, eol, delim, dist)) return;
+            if (sparse) pushCandidate(thread_heaps[t][cust], loc, dist);
+            else setDist(loc, cust, dist);
+            loc_flags[t][loc] = 1;
+            cust_flags[t][cust] = 1;
+            sums[t] += dist;
+            sums_sq[t] += dist * dist;
+            cnts[t]++;
+        });
+    };
+    auto mergeHeaps = [&](uint_t t) {
+        for (uint_t cust = (cust_max_id + 1) * idx_t(t) / thread_cnt; cust < (cust_max_id + 1) * idx_t(t + 1) / thread_cnt; cust++) {
+            for (auto& heaps:thread_heaps) {
+                for (auto& cand:heaps[cust]) pushCandidate(cand_heaps[cust], cand.second, cand.first);
+                vector<pair<dist_t, uint_t>>().swap(heaps[cust]);
+            }
+        }
+    };
+    vector<thread> threads;
+    for (uint_t t = 0; t < thread_cnt; t++) threads.emplace_back(fillRange, t);
+    for (auto& th:threads) th.join();
+    threads.clear();
+    for (uint_t t = 0; t < thread_cnt; t++) threads.emplace_back(fillLines, t);
+    for (auto& th:threads) th.join();
+
+    if (sparse) {
+        threads.clear();
+        for (uint_t t = 0; t < thread_cnt; t++) threads.emplace_back(mergeHeaps, t);
+        for (auto& th:threads) th.join();
+        thread_heaps.clear();
+        buildSparseDist();
+    }
+
+    for (uint_t t = 0; t < thread_cnt; t++) {
+        sum += sums[t];
+        sum_sq += sums_sq[t];
+        cnt += cnts[t];
+    }
+
+    // Extract unique locations and customers
+    for (uint_t loc = 0; loc < loc_max_id + 1; loc++) {
+        for (uint_t t = 0; t < thread_cnt; t++) {
+            if (loc_flags[t][loc]) {locations.push_back(loc); break;}
+        }
+    }
+    for (uint_t cust = 0; cust < cust_max_id + 1; cust++) {
+        for (uint_t t = 0; t < thread_cnt; t++) {
+            if (cust_flags[t][cust]) {customers.push_back(cust); break;}
+        }
+    }
+}
+
 vector<string> tokenize(const string& input, char delim) {
     vector <string> tokens;
     stringstream check1(input);
@@ -63,12 +317,19 @@ vector<string> tokenize(const string& input, char delim) {
 }
 
 
-Instance::Instance(const string &dist_matrix_filename, const string &weights_filename, const string& capacities_filename, uint_t p, char delim, string type_service, uint_t cust_max_id, uint_t loc_max_id) : p(p), type_service(type_service) {
+Instance::Instance(const string &dist_matrix_filename, const string &weights_filename, const string& capacities_filename, uint_t p, char delim, string type_service, uint_t cust_max_id, uint_t loc_max_id, uint_t knn_k, dist_t knn_cutoff) : p(p), type_service(type_service) {
 
     if (strcmp(dist_matrix_filename.c_str(), "euclidian") == 0) {
-        new (this) Instance(cust_max_id, loc_max_id, weights_filename, capacities_filename, p, delim, type_service);
+        new (this) Instance(cust_max_id, loc_max_id, weights_filename, capacities_filename, p, delim, type_service, knn_k, knn_cutoff);
+        return;
+    }else if (isBinaryFile(dist_matrix_filename)) {
+        this->knn_k = knn_k;
+        this->knn_cutoff = knn_cutoff;
+        loadBinary(dist_matrix_filename); // weights and capacities are in the binary file
         return;
     }else{
+        this->knn_k = knn_k;
+        this->knn_cutoff = knn_cutoff;
         // Open streams
         fstream dist_matrix_file(dist_matrix_filename);
         fstream weights_file(weights_filename);
@@ -78,22 +339,19 @@ Instance::Instance(const string &dist_matrix_filename, const string &weights_fil
             loc_max_id = 0;
             cust_max_id = 0;
             string line;
-            // Scan data to determine distance matrix dimensions
+            // Scan the ids of the mapped distance matrix in parallel ranges, the distances are read when filling
             cout << "Scanning input data...\n";
             auto start = tick();
             getline(dist_matrix_file, line); // skip first line
             cout << "Skipped line: " << line << endl;
-            while (getline(dist_matrix_file, line)) {
-                auto tokens = tokenize(line, delim);
-                cust_max_id = max(cust_max_id, (uint_t) stoi(tokens[0]));
-                loc_max_id = max(loc_max_id, (uint_t) stoi(tokens[1]));
-            }
+            dist_matrix_file.close();
+            auto dist_file = mapDistFile(dist_matrix_filename, max(THREAD_NUMBER, 1));
+            dist_t max_dist = 0;
+            scanDistIds(dist_file, delim, cust_max_id, loc_max_id, max_dist);
+            fitDistScale(max_dist);
             this->cust_max_id = cust_max_id;
             this->loc_max_id = loc_max_id;
-            // Clear eof and fail flags, go to beginning
-            dist_matrix_file.clear();
-            dist_matrix_file.seekg(0);
-            uint_t size = (loc_max_id + 1) * (cust_max_id + 1);
+            idx_t size = idx_t(loc_max_id + 1) * (cust_max_id + 1);
             cout << "Distance matrix dimensions: " << loc_max_id + 1 << " x " << cust_max_id + 1 << " = " << size << "\n";
             tock(start);
             // Load weights
@@ -138,44 +396,18 @@ Instance::Instance(const string &dist_matrix_filename, const string &weights_fil
             cout << "Loaded " << cap_cnt << " capacities\n";
             tock(start);
 
-            // Preallocate distance matrix and loc, cust flag vectors
+            // Fill the distance matrix (or the sparse candidate lists) and extract locations and customers
             start = tick();
-            dist_matrix = shared_ptr<dist_t[]>(new dist_t[size], std::default_delete<dist_t[]>());
-            for (uint_t i = 0; i < size; i++) {
-                dist_matrix[i] = DEFAULT_DISTANCE;
-            }
-            vector<bool> loc_flags(loc_max_id + 1, false);
-            vector<bool> cust_flags(cust_max_id + 1, false);
-            // Fill it
             cout << "Loading distance matrix...\n";
             dist_t sum = 0; // sum of distances
             dist_t sum_sq = 0; // sum of squared distances
             uint_t cnt = 0;
-            getline(dist_matrix_file, line); // skip first line
-            cout << "Skipped line: " << line << endl;
-            while (getline(dist_matrix_file, line)) {
-                auto tokens = tokenize(line, delim);
-                auto cust = stoi(tokens[0]);
-                auto loc = stoi(tokens[1]);
-                dist_t dist = stod(tokens[2]);
-                setDist(loc, cust, dist);
-                loc_flags[loc] = true;
-                cust_flags[cust] = true;
-                sum += dist;
-                sum_sq += dist * dist;
-                cnt++;
-            }
+            fillDistMatrix(dist_file, delim, sum, sum_sq, cnt);
+            unmapDistFile(dist_file);
             // Determine stdev and bandwidth
             calculate_Bandwidth(sum, sum_sq, cnt);
 
-
-            // Extract unique locations and customers
-            for (uint_t loc = 0; loc < loc_flags.size(); loc++) {
-                if (loc_flags[loc]) locations.push_back(loc);
-            }
-            for (uint_t cust = 0; cust < cust_flags.size(); cust++) {
-                if (cust_flags[cust]) customers.push_back(cust);
-            }
+            buildIndexTables();
             cout << "locations: " << locations.size() << endl;
             cout << "customers: " << customers.size() << endl;
             cout << "p: " << p << endl;
@@ -199,10 +431,12 @@ Instance::Instance(const string &dist_matrix_filename, const string &weights_fil
 
 
 // Instane construtor and dist matrix with euclidian distances
-Instance::Instance(uint_t cust_max_id, uint_t loc_max_id, const string &weights_filename, const string &capacities_filename, uint_t p, char delim, string type_service) : p(p), type_service(type_service) {
+Instance::Instance(uint_t cust_max_id, uint_t loc_max_id, const string &weights_filename, const string &capacities_filename, uint_t p, char delim, string type_service, uint_t knn_k, dist_t knn_cutoff) : p(p), type_service(type_service) {
 
     this->cust_max_id = cust_max_id;
     this->loc_max_id = loc_max_id;
+    this->knn_k = knn_k;
+    this->knn_cutoff = knn_cutoff;
 
     // Open streams
     fstream weights_file(weights_filename);
@@ -217,7 +451,7 @@ Instance::Instance(uint_t cust_max_id, uint_t loc_max_id, const string &weights_
         // Scan data to determine distance matrix dimensions
         cout << "Scanning input data...\n";
         auto start = tick();
-        uint_t size = (loc_max_id + 1) * (cust_max_id + 1);
+        idx_t size = idx_t(loc_max_id + 1) * (cust_max_id + 1);
         cout << "Distance matrix dimensions: " << loc_max_id + 1 << " x " << cust_max_id + 1 << " = " << size << "\n";
         tock(start);
         // Load weights
@@ -279,12 +513,26 @@ Instance::Instance(uint_t cust_max_id, uint_t loc_max_id, const string &weights_
         if (coord_cnt > 0) cout << "Loaded " << coord_cnt << " coordinates\n";
         tock(start);
 
-        // dist matrix using euclidian distances
+        // dist matrix using euclidian distances, bounded by the diagonal of the bounding box of all points
         start = tick();
         cout << "Loading distance matrix...\n";
-        dist_matrix = shared_ptr<dist_t[]>(new dist_t[size], std::default_delete<dist_t[]>());
-        for (uint_t i = 0; i < size; i++) {
-            dist_matrix[i] = DEFAULT_DISTANCE;
+        dist_t x_min = numeric_limits<dist_t>::max(), x_max = numeric_limits<dist_t>::lowest(), y_min = x_min, y_max = x_max;
+        for (auto coords:{&loc_coordinates, &cust_coordinates}) {
+            for (auto& c:*coords) {
+                x_min = min(x_min, c.first);
+                x_max = max(x_max, c.first);
+                y_min = min(y_min, c.second);
+                y_max = max(y_max, c.second);
+            }
+        }
+        fitDistScale(sqrt((x_max - x_min) * (x_max - x_min) + (y_max - y_min) * (y_max - y_min)));
+        if (knn_k > 0 || knn_cutoff > 0) {
+            cand_heaps.assign(cust_max_id + 1, {});
+        } else {
+            dist_matrix = shared_ptr<dist_store_t[]>(new dist_store_t[size], std::default_delete<dist_store_t[]>());
+            for (idx_t i = 0; i < size; i++) {
+                dist_matrix[i] = encodeDist(DEFAULT_DISTANCE);
+            }
         }
         vector<bool> loc_flags(loc_max_id + 1, false);
         vector<bool> cust_flags(cust_max_id + 1, false);
@@ -321,6 +569,7 @@ Instance::Instance(uint_t cust_max_id, uint_t loc_max_id, const string &weights_
                 }
             }
         }
+        if (!cand_heaps.empty()) buildSparseDist();
 
         // Determine stdev and bandwidth
         calculate_Bandwidth(sum, sum_sq, cnt);
@@ -332,6 +581,7 @@ Instance::Instance(uint_t cust_max_id, uint_t loc_max_id, const string &weights_
         for (uint_t cust = 0; cust < cust_flags.size(); cust++) {
             if (cust_flags[cust]) customers.push_back(cust);
         }
+        buildIndexTables();
         cout << "locations: " << locations.size() << endl;
         cout << "customers: " << customers.size() << endl;
         cout << "p: " << p << endl;
@@ -350,7 +600,154 @@ Instance::Instance(uint_t cust_max_id, uint_t loc_max_id, const string &weights_
 
 }
 
+bool Instance::isBinaryFile(const string& filename) {
+    ifstream file(filename, ios::binary);
+    char magic[8] = {0};
+    if (!file.read(magic, sizeof(magic))) return false;
+    return strcmp(magic, BINARY_MAGIC) == 0;
+}
+
+// Map the binary file read-only: weights, capacities and distances point into the
+// mapping (shared by all processes loading the same file), no parsing
+void Instance::loadBinary(const string& filename) {
+    cout << "Mapping binary instance " << filename << "...\n";
+    auto start = tick();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        cerr << "Error while trying to open the binary instance " << filename << endl;
+        exit(-1);
+    }
+    idx_t length = st.st_size;
+    void* base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED || length < sizeof(BinaryHeader)) {
+        cerr << "Error while trying to map the binary instance " << filename << endl;
+        exit(-1);
+    }
+    shared_ptr<void> mapping(base, [length](void* addr) {munmap(addr, length);});
+    auto bytes = static_cast<const char*>(base);
+
+    BinaryHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    // fixed point codes are read with the scale they were written with
+    bool is_fixed = (binaryDistScale() != 0);
+    if (header.version != BINARY_VERSION || header.dist_bytes != sizeof(dist_store_t) || (header.dist_scale > 0) != is_fixed) {
+        cerr << "Error: binary instance version " << header.version << " with " << header.dist_bytes << "-byte distances (scale "
+             << header.dist_scale << ") does not match this build (version " << BINARY_VERSION << ", " << sizeof(dist_store_t)
+             << " bytes, " << (is_fixed ? "fixed point" : "no scale") << "), convert it again" << endl;
+        exit(-1);
+    }
+#ifdef DIST_FIXED_POINT
+    DIST_SCALE = header.dist_scale;
+    if (DIST_SCALE != DIST_FIXED_SCALE) cout << "[INFO] Fixed-point distance scale of the binary instance: " << DIST_SCALE << endl;
+#endif
+    loc_max_id = header.loc_max_id;
+    cust_max_id = header.cust_max_id;
+    total_demand = header.total_demand;
+    idx_t size = idx_t(loc_max_id + 1) * (cust_max_id + 1);
+
+    idx_t offset = alignBinary(sizeof(header));
+    auto locs = reinterpret_cast<const uint_t*>(bytes + offset);
+    locations.assign(locs, locs + header.num_locations);
+    offset = alignBinary(offset + header.num_locations * sizeof(uint_t));
+    auto custs = reinterpret_cast<const uint_t*>(bytes + offset);
+    customers.assign(custs, custs + header.num_customers);
+    offset = alignBinary(offset + header.num_customers * sizeof(uint_t));
+    idx_t offset_weights = offset;
+    offset = alignBinary(offset + idx_t(cust_max_id + 1) * sizeof(dist_t));
+    idx_t offset_capacities = offset;
+    offset = alignBinary(offset + idx_t(loc_max_id + 1) * sizeof(dist_t));
+    idx_t offset_dists = offset;
+    if (offset_dists + size * sizeof(dist_store_t) > length) {
+        cerr << "Error: binary instance " << filename << " is truncated" << endl;
+        exit(-1);
+    }
+
+    // aliasing shared_ptrs keep the mapping alive as long as any array is used
+    auto data = const_cast<char*>(bytes);
+    cust_weights = shared_ptr<dist_t[]>(mapping, reinterpret_cast<dist_t*>(data + offset_weights));
+    loc_capacities = shared_ptr<dist_t[]>(mapping, reinterpret_cast<dist_t*>(data + offset_capacities));
+    dist_matrix = shared_ptr<dist_store_t[]>(mapping, reinterpret_cast<dist_store_t*>(data + offset_dists));
+    cust_coordinates.assign(cust_max_id + 1, std::make_pair(0, 0));
+    loc_coordinates.assign(loc_max_id + 1, std::make_pair(0, 0));
+
+    if (knn_k > 0 || knn_cutoff > 0) {
+        cand_heaps.assign(cust_max_id + 1, {});
+        for (auto cust:customers)
+            for (auto loc:locations) addCandidate(loc, cust, decodeDist(dist_matrix[getDistIndex(loc, cust)]));
+        buildSparseDist();
+        dist_matrix = nullptr;
+    }
+
+    cout << "Distance matrix dimensions: " << loc_max_id + 1 << " x " << cust_max_id + 1 << " = " << size << "\n";
+    cout << "Total customer demand: " << total_demand << endl;
+    calculate_Bandwidth(header.dist_sum, header.dist_sum_sq, header.dist_cnt);
+    buildIndexTables();
+    cout << "locations: " << locations.size() << endl;
+    cout << "customers: " << customers.size() << endl;
+    cout << "p: " << p << endl;
+    tock(start);
+}
+
+// Write the instance in the binary format read by loadBinary (needs the dense matrix)
+bool Instance::saveBinary(const string& filename) {
+    if (dist_matrix == nullptr) {
+        cerr << "Error: binary conversion needs the dense distance matrix (dist_knn = dist_cutoff = 0)" << endl;
+        return false;
+    }
+    ofstream file(filename, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        cerr << "Error while trying to open the output file " << filename << endl;
+        return false;
+    }
+    cout << "Writing binary instance " << filename << "...\n";
+    auto start = tick();
+
+    BinaryHeader header{};
+    strcpy(header.magic, BINARY_MAGIC);
+    header.version = BINARY_VERSION;
+    header.dist_bytes = sizeof(dist_store_t);
+    header.dist_scale = binaryDistScale();
+    header.loc_max_id = loc_max_id;
+    header.cust_max_id = cust_max_id;
+    header.num_locations = locations.size();
+    header.num_customers = customers.size();
+    header.total_demand = total_demand;
+    header.dist_cnt = dist_cnt; // same statistics as the text loader, h is unchanged
+    header.dist_sum = dist_sum;
+    header.dist_sum_sq = dist_sum_sq;
+
+    idx_t offset = 0;
+    auto writeSection = [&](const void* data, idx_t bytes) {
+        file.write(static_cast<const char*>(data), bytes);
+        offset += bytes;
+        static const char zeros[8] = {0};
+        file.write(zeros, alignBinary(offset) - offset);
+        offset = alignBinary(offset);
+    };
+    idx_t size = idx_t(loc_max_id + 1) * (cust_max_id + 1);
+    writeSection(&header, sizeof(header));
+    writeSection(locations.data(), locations.size() * sizeof(uint_t));
+    writeSection(customers.data(), customers.size() * sizeof(uint_t));
+    writeSection(cust_weights.get(), idx_t(cust_max_id + 1) * sizeof(dist_t));
+    writeSection(loc_capacities.get(), idx_t(loc_max_id + 1) * sizeof(dist_t));
+    writeSection(dist_matrix.get(), size * sizeof(dist_store_t));
+    file.close();
+    if (!file) {
+        cerr << "Error while writing " << filename << endl;
+        return false;
+    }
+    cout << "Wrote " << offset << " bytes\n";
+    tock(start);
+    return true;
+}
+
 void Instance::calculate_Bandwidth(dist_t sum, dist_t sum_sq, uint_t cnt) {
+    dist_sum = sum;
+    dist_sum_sq = sum_sq;
+    dist_cnt = cnt;
     dist_t mean = sum / cnt;
     dist_t variance = sum_sq / cnt - mean * mean;
     dist_t stdev = sqrt(variance);
@@ -371,14 +768,78 @@ void Instance::set_isWeightedObjFunc(bool isWeightedObjFunc) {
 }
 
 
-uint_t Instance::getDistIndex(uint_t loc, uint_t cust) {
-//    return loc * cust_max_id + cust;    // faster extraction of cust values
-    return cust * loc_max_id + loc;    // faster extraction of loc values
+void Instance::setDist(uint_t loc, uint_t cust, dist_t value) {
+    if (!cand_heaps.empty()) {
+        addCandidate(loc, cust, value);
+        return;
+    }
+    idx_t index = getDistIndex(loc, cust);
+    dist_matrix[index] = encodeDist(value);
 }
 
-void Instance::setDist(uint_t loc, uint_t cust, dist_t value) {
-    uint_t index = getDistIndex(loc, cust);
-    dist_matrix[index] = value;
+void Instance::addCandidate(uint_t loc, uint_t cust, dist_t value) {
+    if (cust >= cand_heaps.size()) return;
+    pushCandidate(cand_heaps[cust], loc, value);
+}
+
+// keep the pair if within knn_cutoff and among the knn_k nearest locations in heap
+void Instance::pushCandidate(vector<pair<dist_t, uint_t>>& heap, uint_t loc, dist_t value) {
+    if (knn_cutoff > 0 && value > knn_cutoff) return;
+    if (knn_k == 0) {
+        heap.emplace_back(value, loc);
+    } else if (heap.size() < knn_k) {
+        heap.emplace_back(value, loc);
+        push_heap(heap.begin(), heap.end());
+    } else if (make_pair(value, loc) < heap.front()) { // ties on the location id, independent of the reading order
+        pop_heap(heap.begin(), heap.end());
+        heap.back() = make_pair(value, loc);
+        push_heap(heap.begin(), heap.end());
+    }
+}
+
+// Move the candidate lists to CSR storage sorted by location id
+void Instance::buildSparseDist() {
+    sparse_dists = make_shared<SparseDist>();
+    auto& offsets = sparse_dists->offsets;
+    offsets.assign(cust_max_id + 2, 0);
+    for (uint_t cust = 0; cust < cand_heaps.size(); cust++) {
+        auto& cands = cand_heaps[cust];
+        sort(cands.begin(), cands.end(), [](const pair<dist_t, uint_t>& a, const pair<dist_t, uint_t>& b) {return a.second < b.second;});
+        cands.erase(unique(cands.begin(), cands.end(), [](const pair<dist_t, uint_t>& a, const pair<dist_t, uint_t>& b) {return a.second == b.second;}), cands.end());
+        offsets[cust + 1] = offsets[cust] + cands.size();
+    }
+    sparse_dists->locs.reserve(offsets.back());
+    sparse_dists->dists.reserve(offsets.back());
+    for (auto& cands : cand_heaps) {
+        for (auto c : cands) {
+            sparse_dists->locs.push_back(c.second);
+            sparse_dists->dists.push_back(encodeDist(c.first));
+        }
+        vector<pair<dist_t, uint_t>>().swap(cands);
+    }
+    cand_heaps.clear();
+    cand_heaps.shrink_to_fit();
+
+    cout << "Sparse distances: kept " << offsets.back() << " pairs";
+    if (knn_k > 0) cout << ", " << knn_k << " nearest per customer";
+    if (knn_cutoff > 0) cout << ", cutoff " << knn_cutoff;
+    cout << "\n";
+}
+
+bool Instance::isSparseDist() const {
+    return sparse_dists != nullptr;
+}
+
+bool Instance::keptDistsByIdx(uint_t cust_index, vector<pair<uint_t, dist_t>>& kept) {
+    if (!sparse_dists || packed_dists) return false;
+    kept.clear();
+    auto cust = customers[cust_index];
+    for (auto k = sparse_dists->offsets[cust]; k < sparse_dists->offsets[cust + 1]; k++) {
+        auto loc_index = getLocIndex(sparse_dists->locs[k]); // the rows may be shared with the full instance
+        if (loc_index != NO_INDEX) kept.emplace_back(loc_index, decodeDist(sparse_dists->dists[k]));
+    }
+    sort(kept.begin(), kept.end());
+    return true;
 }
 
 dist_t Instance::getCustWeight(uint_t cust) {
@@ -386,13 +847,18 @@ dist_t Instance::getCustWeight(uint_t cust) {
 }
 
 dist_t Instance::getWeightedDist(uint_t loc, uint_t cust) {
-    uint_t index = getDistIndex(loc, cust);
-    return cust_weights[cust] * dist_matrix[index];
+    return cust_weights[cust] * getRealDist(loc, cust);
 }
 
 dist_t Instance::getRealDist(uint_t loc, uint_t cust) {
-    uint_t index = getDistIndex(loc, cust);
-    return dist_matrix[index];
+    if (packed_dists) {
+        auto loc_index = getLocIndex(loc), cust_index = getCustIndex(cust);
+        if (loc_index != NO_INDEX && cust_index != NO_INDEX)
+            return decodeDist(packed_dists[idx_t(cust_index) * locations.size() + loc_index]);
+    }
+    if (sparse_dists) return sparse_dists->getDist(loc, cust);
+    idx_t index = getDistIndex(loc, cust);
+    return decodeDist(dist_matrix[index]);
 }
 
 void Instance::setVotedLocs(vector<uint_t> voted_locs) {
@@ -424,16 +890,61 @@ Instance Instance::sampleSubproblem(uint_t loc_cnt, uint_t cust_cnt, uint_t p_ne
 
     
 
+    // the sub-PMP reads its distances from its own block, not from the matrix of the orig. instance,
+    // and maps ids to indexes without tables over the whole id range (compact_index)
+    auto packed = [](Instance sub) {
+        sub.packDistances();
+        return sub;
+    };
+
     if (!cover_mode) {
-        return Instance(locations_new, customers_new, cust_weights, loc_capacities, dist_matrix, p_new, loc_max_id, cust_max_id,type_service);
+        return packed(Instance(std::move(locations_new), std::move(customers_new), cust_weights, loc_capacities, dist_matrix, p_new, loc_max_id, cust_max_id,type_service, sparse_dists, true));
     }
 
     if (cover_mode_n2){
         cout << "cover_mode_n2" << endl;
-        return Instance(locations_new, customers_new, cust_weights, loc_capacities, dist_matrix, p_new, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, unique_subareas_n2, loc_coverages_n2, type_subarea_n2);
+        return packed(Instance(std::move(locations_new), std::move(customers_new), cust_weights, loc_capacities, dist_matrix, p_new, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, unique_subareas_n2, loc_coverages_n2, type_subarea_n2, sparse_dists, true));
     }
 
-    return Instance(locations_new, customers_new, cust_weights, loc_capacities, dist_matrix, p_new, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea);
+    return packed(Instance(std::move(locations_new), std::move(customers_new), cust_weights, loc_capacities, dist_matrix, p_new, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, sparse_dists, true));
+}
+
+/*
+ * Copy the distances between the locations and customers of this (sub-)instance into one
+ * row-major block, so the hot loops of a sub-PMP stay in cache instead of jumping around
+ * the (loc_max_id+1)*(cust_max_id+1) matrix of the orig. instance.
+ */
+void Instance::packDistances() {
+    idx_t loc_cnt = locations.size(), cust_cnt = customers.size();
+    shared_ptr<dist_store_t[]> block(new dist_store_t[loc_cnt * cust_cnt]);
+    for (idx_t i = 0; i < cust_cnt; i++)
+        for (idx_t j = 0; j < loc_cnt; j++)
+            block[i * loc_cnt + j] = encodeDist(getRealDist(locations[j], customers[i]));
+    packed_dists = block;
+}
+
+// id -> index tables of locations and customers, behind getLocIndex/getCustIndex and the *ByIdx accessors
+void Instance::buildIndexTables() {
+    if (compact_index) {
+        loc_index_sorted.clear();
+        cust_index_sorted.clear();
+        for (uint_t j = 0; j < locations.size(); j++) loc_index_sorted.emplace_back(locations[j], j);
+        for (uint_t i = 0; i < customers.size(); i++) cust_index_sorted.emplace_back(customers[i], i);
+        sort(loc_index_sorted.begin(), loc_index_sorted.end());
+        sort(cust_index_sorted.begin(), cust_index_sorted.end());
+        return;
+    }
+    uint_t loc_size = loc_max_id + 1, cust_size = cust_max_id + 1;
+    for (auto loc:locations) loc_size = max(loc_size, loc + 1);
+    for (auto cust:customers) cust_size = max(cust_size, cust + 1);
+    loc_index_of.assign(loc_size, NO_INDEX);
+    cust_index_of.assign(cust_size, NO_INDEX);
+    for (uint_t j = 0; j < locations.size(); j++) loc_index_of[locations[j]] = j;
+    for (uint_t i = 0; i < customers.size(); i++) cust_index_of[customers[i]] = i;
+}
+
+dist_t Instance::capacityByIdx(uint_t loc_index) {
+    return loc_capacities[locations[loc_index]];
 }
 
 void Instance::print() {
@@ -527,14 +1038,14 @@ Instance Instance::getReducedSubproblem(const vector<uint_t> &locations_new, str
     // return Instance(locations_new, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id, type_service);
 
     if (!cover_mode) {
-        return Instance(locations_new, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service);
+        return Instance(locations_new, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, sparse_dists);
     }
 
     if (cover_mode_n2){
-        return Instance(locations_new, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, unique_subareas_n2, loc_coverages_n2, type_subarea_n2);
+        return Instance(locations_new, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, unique_subareas_n2, loc_coverages_n2, type_subarea_n2, sparse_dists);
     }
 
-    return Instance(locations_new, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea);
+    return Instance(locations_new, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, sparse_dists);
 
 
 }
@@ -844,37 +1355,6 @@ bool Instance::isPcoversAllSubareas_n2(unordered_set<uint_t> p_loc_cand){
 
 }
 
-uint_t Instance::getLocIndex(uint_t loc){
-
-    auto it = find(locations.begin(), locations.end(), loc);
-    // Check if element was found and get its index
-    uint_t index=10000000; // UNINT_MAX
-    if (it != locations.end()) {
-        index = distance(locations.begin(), it); // Calculate index using iterator
-        // cout << "Index of " << loc << " is: " << index << endl;
-    } else {
-        cout << "Element not found in vector." << endl;
-    }
-
-    return index;
-}
-
-uint_t Instance::getCustIndex(uint_t cust){
-
-    auto it = find(customers.begin(), customers.end(), cust);
-    // Check if element was found and get its index
-    uint_t index=10000000; // UNINT_MAX
-    if (it != customers.end()) {
-        index = distance(customers.begin(), it); // Calculate index using iterator
-        // cout << "Index of " << cust << " is: " << index << endl;
-    } else {
-        cout << "Element not found in vector." << endl;
-    }
-
-    return index;
-    
-}
-
 Instance Instance::filterInstance(string type_service) {
 
     // remove all locations with capacity less or equal than 1
@@ -887,14 +1367,14 @@ Instance Instance::filterInstance(string type_service) {
     
     // getReducedSubproblem(locations_filtered, type_service);
     if (!cover_mode) {
-        return Instance(locations_filtered, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service);
+        return Instance(locations_filtered, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, sparse_dists);
     }
 
     if (cover_mode_n2){
-        return Instance(locations_filtered, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, unique_subareas_n2, loc_coverages_n2, type_subarea_n2);
+        return Instance(locations_filtered, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, unique_subareas_n2, loc_coverages_n2, type_subarea_n2, sparse_dists);
     }
 
-    return Instance(locations_filtered, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea);
+    return Instance(locations_filtered, customers, cust_weights, loc_capacities, dist_matrix, p, loc_max_id, cust_max_id,type_service, unique_subareas, loc_coverages, type_subarea, sparse_dists);
 }
 
 void Instance::set_ThresholdDist(dist_t threshold_dist){
@@ -10,6 +10,7 @@
 #include <utility>
 #include <random>
 #include <limits.h>
+#include <limits>
 #include <algorithm>
 #include <math.h>
 #include "utils.hpp"
@@ -17,13 +18,79 @@
 
 using namespace std;
 
+inline dist_store_t encodeDist(dist_t dist) {
+#ifdef DIST_FIXED_POINT
+    const dist_t max_code = numeric_limits<dist_store_t>::max();
+    if (dist >= DEFAULT_DISTANCE) return max_code;
+    return static_cast<dist_store_t>(min(max_code - 1, max(dist_t(0), round(dist * DIST_SCALE))));
+#else
+    return static_cast<dist_store_t>(dist);
+#endif
+}
+
+inline dist_t decodeDist(dist_store_t code) {
+#ifdef DIST_FIXED_POINT
+    if (code == numeric_limits<dist_store_t>::max()) return DEFAULT_DISTANCE;
+    return dist_t(code) / DIST_SCALE;
+#else
+    return code;
+#endif
+}
+
+/*
+ * Sparse distance storage: for each customer the kept candidate locations
+ * (K nearest and/or within a cutoff) in CSR form, sorted by location id.
+ * Pairs that were not kept are at DEFAULT_DISTANCE.
+ */
+struct SparseDist {
+    vector<idx_t> offsets; // customer id -> first candidate, size cust_max_id + 2
+    vector<uint_t> locs;
+    vector<dist_store_t> dists;
+
+    dist_t getDist(uint_t loc, uint_t cust) const {
+        auto first = locs.begin() + offsets[cust];
+        auto last = locs.begin() + offsets[cust + 1];
+        auto it = lower_bound(first, last, loc);
+        if (it == last || *it != loc) return DEFAULT_DISTANCE;
+        return decodeDist(dists[it - locs.begin()]);
+    }
+};
+
+struct DistFile;
+
+#define NO_INDEX UINT_MAX // id not in the (sub-)instance
+
 class Instance {
 private:
     vector<uint_t> locations;
     vector<uint_t> customers;
     shared_ptr<dist_t[]> cust_weights;
     shared_ptr<dist_t[]> loc_capacities;
-    shared_ptr<dist_t[]> dist_matrix;
+    shared_ptr<dist_store_t[]> dist_matrix;
+    shared_ptr<SparseDist> sparse_dists; // used instead of dist_matrix when set
+
+    // sub-instances: own distances in one block, customer index * locations.size() + location index
+    shared_ptr<dist_store_t[]> packed_dists;
+    void packDistances();
+
+    vector<uint_t> loc_index_of;  // location id -> index in locations (NO_INDEX if absent)
+    vector<uint_t> cust_index_of; // customer id -> index in customers (NO_INDEX if absent)
+    // sampled sub-instances: (id, index) sorted by id instead, sized to the sub-instance and not to the id range
+    bool compact_index = false;
+    vector<pair<uint_t, uint_t>> loc_index_sorted, cust_index_sorted;
+    void buildIndexTables();
+    static uint_t findIndex(const vector<pair<uint_t, uint_t>>& index_sorted, uint_t id);
+
+    // sparse storage while loading: customer id -> (dist, loc), a max-heap on dist when knn_k > 0
+    uint_t knn_k=0;
+    dist_t knn_cutoff=0;
+    vector<vector<pair<dist_t, uint_t>>> cand_heaps;
+    void addCandidate(uint_t loc, uint_t cust, dist_t value);
+    void pushCandidate(vector<pair<dist_t, uint_t>>& heap, uint_t loc, dist_t value);
+    void buildSparseDist();
+    void loadBinary(const string& filename);
+    void fillDistMatrix(const DistFile& file, char delim, dist_t& sum, dist_t& sum_sq, uint_t& cnt);
+    static void fitDistScale(dist_t max_dist);
 
     uint_t p;
     uint_t loc_max_id; // kept for addressing the full distance matrix
@@ -31,6 +98,8 @@ private:
     uint_t cover_max_id=0; 
     uint_t cover_n2_max_id=0; 
     dist_t h; // bandwidth
+    dist_t dist_sum=0, dist_sum_sq=0; // statistics behind h (kept for the binary format)
+    uint_t dist_cnt=0;
     uint_t total_demand;
     const string type_service;
     vector<uint_t> voted_locs;
@@ -53,12 +122,14 @@ private:
     dist_t threshold_dist=0;
 public:
     // Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights, shared_ptr<dist_t[]> dist_matrix, shared_ptr<dist_t[]> loc_capacities, uint_t p, uint_t loc_max, uint_t cust_max, string type_service);    
-    Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights, shared_ptr<dist_t[]> loc_capacities,shared_ptr<dist_t[]> dist_matrix, uint_t p, uint_t loc_max, uint_t cust_max, string type_service);    
-    Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights, shared_ptr<dist_t[]> loc_capacities,shared_ptr<dist_t[]> dist_matrix, uint_t p, uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea);
-    Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights, shared_ptr<dist_t[]> loc_capacities,shared_ptr<dist_t[]> dist_matrix, uint_t p, uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea, unordered_set<uint_t> unique_subareas_n2, shared_ptr<uint_t[]> loc_coverages_n2, string type_subarea_n2);
-    Instance(const string& dist_matrix_filename, const string& weights_filename, const string& capacities_filename, uint_t p, char delim, string type_service="null",uint_t cust_max_id=0, uint_t loc_max_id=0);
-    Instance(uint_t cust_max_id, uint_t loc_max_id, const string& weights_filename, const string& capacities_filename, uint_t p, char delim, string type_service="null");
+    Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights, shared_ptr<dist_t[]> loc_capacities,shared_ptr<dist_store_t[]> dist_matrix, uint_t p, uint_t loc_max, uint_t cust_max, string type_service, shared_ptr<SparseDist> sparse_dists=nullptr, bool compact_index=false);    
+    Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights, shared_ptr<dist_t[]> loc_capacities,shared_ptr<dist_store_t[]> dist_matrix, uint_t p, uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea, shared_ptr<SparseDist> sparse_dists=nullptr, bool compact_index=false);
+    Instance(vector<uint_t> locations, vector<uint_t> customers, shared_ptr<dist_t[]> cust_weights, shared_ptr<dist_t[]> loc_capacities,shared_ptr<dist_store_t[]> dist_matrix, uint_t p, uint_t loc_max, uint_t cust_max, string type_service, unordered_set<uint_t> unique_subareas, shared_ptr<uint_t[]> loc_coverages, string type_subarea, unordered_set<uint_t> unique_subareas_n2, shared_ptr<uint_t[]> loc_coverages_n2, string type_subarea_n2, shared_ptr<SparseDist> sparse_dists=nullptr, bool compact_index=false);
+    Instance(const string& dist_matrix_filename, const string& weights_filename, const string& capacities_filename, uint_t p, char delim, string type_service="null",uint_t cust_max_id=0, uint_t loc_max_id=0, uint_t knn_k=0, dist_t knn_cutoff=0);
+    Instance(uint_t cust_max_id, uint_t loc_max_id, const string& weights_filename, const string& capacities_filename, uint_t p, char delim, string type_service="null", uint_t knn_k=0, dist_t knn_cutoff=0);
     void calculate_Bandwidth(dist_t sum, dist_t sum_sq, uint_t cnt);
+    bool saveBinary(const string& filename);
+    static bool isBinaryFile(const string& filename);
     
 
 
@@ -73,9 +144,17 @@ public:
     const vector<uint_t>& getCustomers() const;
     const vector<uint_t>& getLocations() const;
     uint_t get_p() const;
-    uint_t getDistIndex(uint_t loc, uint_t cust);
+    idx_t getDistIndex(uint_t loc, uint_t cust);
+    bool isSparseDist() const;
     uint_t getLocIndex(uint_t loc);
     uint_t getCustIndex(uint_t cust);
+    // dense index accessors: location index in getLocations(), customer index in getCustomers()
+    dist_t distByIdx(uint_t loc_index, uint_t cust_index);
+    dist_t weightByIdx(uint_t cust_index);
+    dist_t capacityByIdx(uint_t loc_index);
+    // (location index, distance) of the distances kept for a customer, sorted by location index;
+    // false for dense storage, where every pair has to be read with distByIdx
+    bool keptDistsByIdx(uint_t cust_index, vector<pair<uint_t, dist_t>>& kept);
     uint_t getClosestCust(uint_t loc);
     double getVotingScore(uint_t loc, uint_t cust);
     dist_t getLocCapacity(uint_t loc);
@@ -111,5 +190,39 @@ public:
 
 };
 
+// index lookups and *ByIdx accessors sit in the inner loops of the solvers, kept inline
+
+inline idx_t Instance::getDistIndex(uint_t loc, uint_t cust) {
+//    return loc * cust_max_id + cust;    // faster extraction of cust values
+    return idx_t(cust) * loc_max_id + loc;    // faster extraction of loc values
+}
+
+inline uint_t Instance::findIndex(const vector<pair<uint_t, uint_t>>& index_sorted, uint_t id) {
+    auto it = lower_bound(index_sorted.begin(), index_sorted.end(), make_pair(id, uint_t(0)));
+    if (it == index_sorted.end() || it->first != id) return NO_INDEX;
+    return it->second;
+}
+
+inline uint_t Instance::getLocIndex(uint_t loc) {
+    if (compact_index) return findIndex(loc_index_sorted, loc);
+    if (loc >= loc_index_of.size()) return NO_INDEX;
+    return loc_index_of[loc];
+}
+
+inline uint_t Instance::getCustIndex(uint_t cust) {
+    if (compact_index) return findIndex(cust_index_sorted, cust);
+    if (cust >= cust_index_of.size()) return NO_INDEX;
+    return cust_index_of[cust];
+}
+
+inline dist_t Instance::distByIdx(uint_t loc_index, uint_t cust_index) {
+    if (packed_dists) return decodeDist(packed_dists[idx_t(cust_index) * locations.size() + loc_index]);
+    if (sparse_dists) return getRealDist(locations[loc_index], customers[cust_index]);
+    return decodeDist(dist_matrix[getDistIndex(locations[loc_index], customers[cust_index])]);
+}
+
+inline dist_t Instance::weightByIdx(uint_t cust_index) {
+    return cust_weights[customers[cust_index]];
+}
 
 #endif //LARGE_PMP_INSTANCE_HPP
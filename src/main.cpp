@@ -2,6 +2,9 @@
 #include <cstring>
 #include <string>
 #include <chrono> // for time-related functions
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 using namespace std;
 using namespace std::chrono;
 
@@ -38,6 +41,7 @@ struct Config {
     string Method;
     string Method_RSSV_sp;
     string Method_RSSV_fp;
+    string TypeEval_Cap = "GAP";
     bool VERBOSE = false;
     uint_t TOLERANCE_CPT = 10;
     uint_t K = 1;
@@ -47,14 +51,22 @@ struct Config {
     double CLOCK_LIMIT_SUBPROB_RSSV = 0;
     uint_t MAX_ITE_SUBPROB_RSSV = 0;
     uint_t size_subproblems_rssv = 800;
+    uint_t convergence_window_rssv = 0;     // > 0: stop RSSV sampling once the voting ranking is stable
+    double convergence_overlap_rssv = 0.95; // share of the top voted locations kept between two windows
 
     double BW_MULTIPLIER = 1.0;
     bool add_threshold_distance_rssv = false;
+    bool pipeline_rssv = false; // start the TB final phase on provisional filtered instances while sampling
+    string rssv_address = "unix:/tmp/large_pmp_rssv.sock"; // coordinator/worker RSSV: unix:<path> or <host>:<port>
+    uint_t rssv_remote_workers = 0; // > 0: RSSV waits for this many worker processes on rssv_address
+    bool cplex_var_names = false; // name the CPLEX variables of the exact methods (exported models, debugging)
 
     bool cover_mode = false;
     bool cover_mode_n2 = false;
     uint_t cust_max_id = 0;
     uint_t loc_max_id = 0;
+    uint_t dist_knn = 0;      // > 0: keep only the dist_knn nearest locations of each customer
+    double dist_cutoff = 0;   // > 0: keep only the distances <= dist_cutoff
     bool IsWeighted_ObjFunc = false;
     set<const char*> configOverride;
     string configPath = "config.toml";
@@ -90,6 +102,12 @@ void parseArguments(int argc, char* argv[], Config& config) {
             }else if (key == "-loc_max_id") {
                 config.loc_max_id = std::stoi(argv[i+1]);
                 configOverride.insert("loc_max_id");
+            } else if (key == "-dist_knn") {
+                config.dist_knn = std::stoi(argv[i+1]);
+                configOverride.insert("dist_knn");
+            } else if (key == "-dist_cutoff") {
+                config.dist_cutoff = std::stod(argv[i+1]);
+                configOverride.insert("dist_cutoff");
             }else if (key == "--mode") {
                 config.mode = std::stoi(argv[i+1]);
                 configOverride.insert("mode");
@@ -117,6 +135,12 @@ void parseArguments(int argc, char* argv[], Config& config) {
             }else if (key == "-max_ite_subprob_rssv") {
                 config.MAX_ITE_SUBPROB_RSSV = std::stoi(argv[i+1]);
                 configOverride.insert("max_ite_subprob_rssv");
+            }else if (key == "-convergence_window_rssv") {
+                config.convergence_window_rssv = std::stoi(argv[i+1]);
+                configOverride.insert("convergence_window_rssv");
+            }else if (key == "-convergence_overlap_rssv") {
+                config.convergence_overlap_rssv = std::stod(argv[i+1]);
+                configOverride.insert("convergence_overlap_rssv");
             } else if (key == "-o") {
                 config.output_filename = argv[i+1];
                 configOverride.insert("output");
@@ -156,6 +180,15 @@ void parseArguments(int argc, char* argv[], Config& config) {
             } else if (key == "-method_rssv_fp") {
                 config.Method_RSSV_fp = argv[i+1];
                 configOverride.insert("method_rssv_fp");
+            } else if (key == "-type_eval_cap") {
+                config.TypeEval_Cap = argv[i+1];
+                configOverride.insert("type_eval_cap");
+            } else if (key == "-rssv_address") {
+                config.rssv_address = argv[i+1];
+                configOverride.insert("rssv_address");
+            } else if (key == "-rssv_remote_workers") {
+                config.rssv_remote_workers = std::stoi(argv[i+1]);
+                configOverride.insert("rssv_remote_workers");
             } else if (key == "-size_subproblems_rssv") {
                 config.size_subproblems_rssv = std::stoi(argv[i+1]);
                 configOverride.insert("size_subproblems_rssv");
@@ -191,8 +224,27 @@ void parseArguments(int argc, char* argv[], Config& config) {
                     throw std::invalid_argument("Unknown parameter [add_threshold_distance_rssv]: " + std::string(argv[i+1]));
                 }
                 configOverride.insert("add_threshold_distance_rssv");
+            } else if (key == "-pipeline_rssv") {
+                if (strcmp(argv[i+1], "true") == 0 || strcmp(argv[i+1], "1") == 0) {
+                    config.pipeline_rssv = true;
+                } else if (strcmp(argv[i+1], "false") == 0 || strcmp(argv[i+1], "0") == 0) {
+                    config.pipeline_rssv = false;
+                } else {
+                    throw std::invalid_argument("Unknown parameter [pipeline_rssv]: " + std::string(argv[i+1]));
+                }
+                configOverride.insert("pipeline_rssv");
+            } else if (key == "-cplex_var_names") {
+                if (strcmp(argv[i+1], "true") == 0 || strcmp(argv[i+1], "1") == 0) {
+                    config.cplex_var_names = true;
+                } else if (strcmp(argv[i+1], "false") == 0 || strcmp(argv[i+1], "0") == 0) {
+                    config.cplex_var_names = false;
+                } else {
+                    throw std::invalid_argument("Unknown parameter [cplex_var_names]: " + std::string(argv[i+1]));
+                }
+                configOverride.insert("cplex_var_names");
             } else if (key == "--help" || key == "-h" || key == "?") {
                 std::cout << "Usage instructions:\n";
+                std::cout << "convert -dm <file> -w <file> -c <file> -o <file.bin> : Write the instance in binary format (then use -dm <file.bin>).\n";
                 std::cout << "-p <value>          : Number of medians to select.\n";
                 std::cout << "-dm <filename>      : Path to the distance matrix file.\n";
                 std::cout << "-w <filename>       : Path to the labeled weights file.\n";
@@ -220,6 +272,8 @@ void setupConfig(Config& config, std::set<const char*>& configOverride) {
     configParser.setFromConfig(&config.mode, "mode");
     configParser.setFromConfig(&config.cust_max_id, "cust_max_id");
     configParser.setFromConfig(&config.loc_max_id, "loc_max_id");
+    configParser.setFromConfig(&config.dist_knn, "dist_knn");
+    configParser.setFromConfig(&config.dist_cutoff, "dist_cutoff");
     configParser.setFromConfig(&config.seed, "seed");
     configParser.setFromConfig(&config.CLOCK_LIMIT, "time");
     configParser.setFromConfig(&config.CLOCK_LIMIT_CPLEX, "time_cplex");
@@ -230,6 +284,7 @@ void setupConfig(Config& config, std::set<const char*>& configOverride) {
     configParser.setFromConfig(&config.Method, "method");
     configParser.setFromConfig(&config.Method_RSSV_sp, "method_rssv_sp");
     configParser.setFromConfig(&config.Method_RSSV_fp, "method_rssv_fp");
+    configParser.setFromConfig(&config.TypeEval_Cap, "type_eval_cap");
     configParser.setFromConfig(&config.coverages_filename_n2, "coverages_n2");
     configParser.setFromConfig(&config.size_subproblems_rssv, "size_subproblems_rssv");
     configParser.setFromConfig(&config.TypeSubarea, "subarea");
@@ -240,6 +295,12 @@ void setupConfig(Config& config, std::set<const char*>& configOverride) {
     configParser.setFromConfig(&config.add_threshold_distance_rssv, "add_threshold_distance_rssv");
     configParser.setFromConfig(&config.MAX_ITE_SUBPROB_RSSV, "max_ite_subprob_rssv");
     configParser.setFromConfig(&config.CLOCK_LIMIT_SUBPROB_RSSV, "time_subprob_rssv");
+    configParser.setFromConfig(&config.convergence_window_rssv, "convergence_window_rssv");
+    configParser.setFromConfig(&config.convergence_overlap_rssv, "convergence_overlap_rssv");
+    configParser.setFromConfig(&config.pipeline_rssv, "pipeline_rssv");
+    configParser.setFromConfig(&config.rssv_address, "rssv_address");
+    configParser.setFromConfig(&config.rssv_remote_workers, "rssv_remote_workers");
+    configParser.setFromConfig(&config.cplex_var_names, "cplex_var_names");
     configParser.setFromConfig(&config.BW_MULTIPLIER, "bw_multiplier");
 
     // Additional fields can be set similarly
@@ -260,6 +321,7 @@ void checkRequiredParameters(const Config& config) {
         std::cerr << "Error: Distance matrix (-dm) not provided.\n";
         exit(1);
     }
+    if (Instance::isBinaryFile(config.dist_matrix_filename)) return; // weights and capacities are in the binary file
     if (config.labeled_weights_filename.empty()) {
         std::cerr << "Error: Customer weights (-w) not provided.\n";
         exit(1);
@@ -281,7 +343,9 @@ Instance setupInstance(const Config& config) {
                       config.p, ' ', 
                       config.TypeService, 
                       config.cust_max_id, 
-                      config.loc_max_id);
+                      config.loc_max_id,
+                      config.dist_knn,
+                      config.dist_cutoff);
 
     if (!config.coverages_filename.empty() && config.cover_mode) {
         instance.ReadCoverages(config.coverages_filename, config.TypeSubarea, ' ');
@@ -303,6 +367,10 @@ Instance setupInstance(const Config& config) {
 Solution_MAP solution_map;
 Solution_std methods_PMP(const shared_ptr<Instance>& instance, const Config& config, double external_time);
 Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& config, double external_time);
+template <typename SolutionType>
+SolutionType runPipelinedRSSV(RSSV& metaheuristic, const function<shared_ptr<Instance>(uint_t)>& runSampling,
+                              const Config& config, shared_ptr<Instance>& final_instance,
+                              high_resolution_clock::time_point start_time_total);
 void solveProblem(const Instance& instance, const Config& config, int seed);
 
 
@@ -317,12 +385,31 @@ int main(int argc, char *argv[]) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
+    setThreadNumber(config.threads_cnt);
+
+    // large_PMP convert -dm <dist_matrix> -w <weights> -c <capacities> -o <instance.bin>
+    if (argc > 1 && strcmp(argv[1], "convert") == 0) {
+        if (config.dist_matrix_filename.empty() || config.labeled_weights_filename.empty() ||
+            config.capacities_filename.empty() || config.output_filename.empty()) {
+            std::cerr << "Error: convert needs -dm, -w, -c and -o.\n";
+            return 1;
+        }
+        Instance instance(config.dist_matrix_filename, config.labeled_weights_filename, config.capacities_filename,
+                          config.p, ' ', config.TypeService, config.cust_max_id, config.loc_max_id);
+        return instance.saveBinary(config.output_filename) ? 0 : 1;
+    }
+
     // Check required parameters before proceeding
     checkRequiredParameters(config);
-    setThreadNumber(config.threads_cnt);
 
     Instance instance = setupInstance(config);
 
+    // large_PMP worker -rssv_address <address> -dm ... : solve the sub-PMPs of an RSSV coordinator
+    if (argc > 1 && strcmp(argv[1], "worker") == 0) {
+        CLOCK_THREADED = true;
+        return RSSV::runWorker(make_shared<Instance>(instance), config.rssv_address);
+    }
+
     // filter instance
     // Instance instance_original = setupInstance(config); // Instance instance = instance_original.filterInstance(TypeService);
 
@@ -338,7 +425,7 @@ int main(int argc, char *argv[]) {
 void solveProblem(const Instance& instance, const Config& config, int seed) {
     cout << "-------------------------------------------------\n";
     
-    if (config.Method == "EXACT_PMP" || config.Method == "TB_PMP" || config.Method == "VNS_PMP") {
+    if (config.Method == "EXACT_PMP" || config.Method == "TB_PMP" || config.Method == "TB_PMP_FAST" || config.Method == "VNS_PMP") {
         auto start_time = high_resolution_clock::now(); // only clock can give CPU time
         Solution_std solution = methods_PMP(make_shared<Instance>(instance), config, 0);
         auto current_time = high_resolution_clock::now();
@@ -388,22 +475,58 @@ void solveProblem(const Instance& instance, const Config& config, int seed) {
         metaheuristic.setMAX_ITE_SUBPROBLEMS(config.MAX_ITE_SUBPROB_RSSV);
         metaheuristic.setTIME_LIMIT_SUBPROBLEMS(config.CLOCK_LIMIT_SUBPROB_RSSV);
         metaheuristic.setAddThresholdDist(config.add_threshold_distance_rssv);
+        metaheuristic.setTypeEval(config.TypeEval_Cap);
+        metaheuristic.setConvergence(config.convergence_window_rssv, config.convergence_overlap_rssv);
+        metaheuristic.setRemoteWorkers(config.rssv_address, config.rssv_remote_workers);
         CLOCK_THREADED = true;
         auto start_time_total = high_resolution_clock::now();
 
-        shared_ptr<Instance> filtered_instance;
-        if (config.Method_RSSV_sp == "EXACT_PMP" || config.Method_RSSV_sp == "TB_PMP" || config.Method_RSSV_sp == "VNS_PMP") {
-            filtered_instance = metaheuristic.run(THREAD_NUMBER, config.Method_RSSV_sp);
-        } 
-        else if (config.Method_RSSV_sp == "EXACT_CPMP" || config.Method_RSSV_sp == "EXACT_CPMP_BIN" || 
-                 config.Method_RSSV_sp == "TB_CPMP" || config.Method_RSSV_sp == "VNS_CPMP") {
-            filtered_instance = metaheuristic.run_CAP(THREAD_NUMBER, config.Method_RSSV_sp);
-        } 
-        else {
+        function<shared_ptr<Instance>(uint_t)> runSampling = [&](uint_t thread_cnt) -> shared_ptr<Instance> {
+            if (config.Method_RSSV_sp == "EXACT_PMP" || config.Method_RSSV_sp == "TB_PMP" || config.Method_RSSV_sp == "TB_PMP_FAST" || config.Method_RSSV_sp == "VNS_PMP") {
+                return metaheuristic.run(thread_cnt, config.Method_RSSV_sp);
+            } 
+            else if (config.Method_RSSV_sp == "EXACT_CPMP" || config.Method_RSSV_sp == "EXACT_CPMP_BIN" || 
+                     config.Method_RSSV_sp == "TB_CPMP" || config.Method_RSSV_sp == "VNS_CPMP") {
+                return metaheuristic.run_CAP(thread_cnt, config.Method_RSSV_sp);
+            } 
             cerr << "[ERROR] Method subproblem RSSV not found" << endl;
             exit(1);
+        };
+
+        bool pipelined = config.pipeline_rssv && (config.Method_RSSV_fp == "TB_PMP" || config.Method_RSSV_fp == "TB_PMP_FAST" || config.Method_RSSV_fp == "TB_CPMP");
+        if (config.pipeline_rssv && !pipelined) {
+            cout << "[WARN] pipeline_rssv needs a TB final problem (TB_PMP, TB_PMP_FAST, TB_CPMP), solving " << config.Method_RSSV_fp << " after the sampling\n";
+        }
+        if (pipelined) {
+            cout << "-------------------------------------------------\n";
+            cout << "Pipelined RSSV: final problem " << config.Method_RSSV_fp << " during the sampling\n";
+            cout << "-------------------------------------------------\n";
+            shared_ptr<Instance> final_instance;
+            if (config.Method_RSSV_fp == "TB_CPMP") {
+                Solution_cap solution = runPipelinedRSSV<Solution_cap>(metaheuristic, runSampling, config, final_instance, start_time_total);
+                solution = Solution_cap(final_instance, solution.get_pLocations(), config.TypeEval_Cap == "TRANSPORT" ? "TRANSPORT" : "GAPrelax", config.cover_mode);
+                auto elapsed_time = duration_cast<seconds>(high_resolution_clock::now() - start_time_total).count();
+
+                cout << "\nFinal solution:\n";
+                solution.print();
+                cout << "Final total elapsed time: " << elapsed_time << "s\n";
+                solution.saveAssignment(config.output_filename, "RSSV_" + config.Method_RSSV_fp, elapsed_time);
+                solution.saveResults(config.output_filename, elapsed_time, metaheuristic.getNumSubproblemsSolved(), config.Method, config.Method_RSSV_sp, config.Method_RSSV_fp);
+            } else {
+                Solution_std solution = runPipelinedRSSV<Solution_std>(metaheuristic, runSampling, config, final_instance, start_time_total);
+                auto elapsed_time = duration_cast<seconds>(high_resolution_clock::now() - start_time_total).count();
+
+                cout << "\nFinal solution std:\n";
+                solution.print();
+                cout << "Final total elapsed time: " << elapsed_time << "s\n";
+                solution.saveAssignment(config.output_filename, config.Method, elapsed_time);
+                solution.saveResults(config.output_filename, elapsed_time, metaheuristic.getNumSubproblemsSolved(), config.Method);
+            }
+            return;
         }
 
+        shared_ptr<Instance> filtered_instance = runSampling(THREAD_NUMBER);
+
         filtered_instance->setCoverModel(config.cover_mode);
         filtered_instance->setCoverModel_n2(config.cover_mode_n2);
         filtered_instance->set_isWeightedObjFunc(config.IsWeighted_ObjFunc);
@@ -415,7 +538,7 @@ void solveProblem(const Instance& instance, const Config& config, int seed) {
         cout << "Final Problem RSSV heuristic \n";
         cout << "-------------------------------------------------\n";
         
-        if (config.Method_RSSV_fp == "EXACT_PMP" || config.Method_RSSV_fp == "TB_PMP" || config.Method_RSSV_fp == "VNS_PMP") {
+        if (config.Method_RSSV_fp == "EXACT_PMP" || config.Method_RSSV_fp == "TB_PMP" || config.Method_RSSV_fp == "TB_PMP_FAST" || config.Method_RSSV_fp == "VNS_PMP") {
             auto start_time = high_resolution_clock::now();
             Solution_std solution = methods_PMP(filtered_instance, config,
                                     duration_cast<seconds>(high_resolution_clock::now() - start_time_total).count());
@@ -427,7 +550,7 @@ void solveProblem(const Instance& instance, const Config& config, int seed) {
             cout << "Final problem elapsed time: " << elapsed_time << "s\n";
             cout << "Final total elapsed time: " << duration_cast<seconds>(current_time - start_time_total).count() << "s\n";
             solution.saveAssignment(config.output_filename, config.Method, elapsed_time);
-            solution.saveResults(config.output_filename, elapsed_time, 0, config.Method); 
+            solution.saveResults(config.output_filename, elapsed_time, metaheuristic.getNumSubproblemsSolved(), config.Method); 
         } 
         else if (config.Method_RSSV_fp == "EXACT_CPMP" || config.Method_RSSV_fp == "EXACT_CPMP_BIN" || 
                  config.Method_RSSV_fp == "TB_CPMP" || config.Method_RSSV_fp == "VNS_CPMP") {
@@ -446,7 +569,7 @@ void solveProblem(const Instance& instance, const Config& config, int seed) {
             cout << "Final elapsed time: " << elapsed_time << "s\n";
             cout << "Final total elapsed time: " << duration_cast<seconds>(current_time - start_time_total).count() << "s\n";
             solution.saveAssignment(config.output_filename, "RSSV_" + config.Method_RSSV_fp, elapsed_time);
-            solution.saveResults(config.output_filename, elapsed_time, 0, config.Method, config.Method_RSSV_sp, config.Method_RSSV_fp);
+            solution.saveResults(config.output_filename, elapsed_time, metaheuristic.getNumSubproblemsSolved(), config.Method, config.Method_RSSV_sp, config.Method_RSSV_fp);
             cout << "\n\n\n";
         }
     }
@@ -456,33 +579,41 @@ void solveProblem(const Instance& instance, const Config& config, int seed) {
 
 Solution_std methods_PMP(const shared_ptr<Instance>& instance, const Config& config, double external_time) {
     Solution_std solution;
-    cout << "-------------------------------------------------\n";
 
-    if (config.Method == "EXACT_PMP") {
+    string Method = config.Method;
+    if (Method == "RSSV") {
+        Method = config.Method + "_" + config.Method_RSSV_fp;
+    }
+
+    cout << "-------------------------------------------------\n";
+    if (Method == "EXACT_PMP" || Method == "RSSV_EXACT_PMP") {
         cout << "Exact method PMP\n";
         cout << "-------------------------------------------------\n";
         PMP pmp(instance, "PMP");
         pmp.setCoverModel(config.cover_mode, instance->getTypeSubarea());
         pmp.setCoverModel_n2(config.cover_mode_n2, instance->getTypeSubarea_n2());
-        pmp.run(config.Method);
-        pmp.saveVars(config.output_filename, config.Method);
-        pmp.saveResults(config.output_filename, config.Method);
+        pmp.setNameVars(config.cplex_var_names);
+        pmp.run(Method);
+        pmp.saveVars(config.output_filename, Method);
+        pmp.saveResults(config.output_filename, Method);
         solution = pmp.getSolution_std();
-    } else if (config.Method == "TB_PMP") {
+    } else if (Method == "TB_PMP" || Method == "TB_PMP_FAST" || Method == "RSSV_TB_PMP" || Method == "RSSV_TB_PMP_FAST") {
         cout << "TB heuristic - standard PMP\n";
         cout << "-------------------------------------------------\n";
         TB heuristic(instance, config.seed);
         heuristic.setCoverMode(config.cover_mode);
         heuristic.setCoverMode_n2(config.cover_mode_n2);
         heuristic.setTimeLimit(config.CLOCK_LIMIT);
+        heuristic.setFastSwap(Method == "TB_PMP_FAST" || Method == "RSSV_TB_PMP_FAST");
         solution = heuristic.run(true, UB_MAX_ITER);
-    } else if (config.Method == "VNS_PMP") {
+    } else if (Method == "VNS_PMP" || Method == "RSSV_VNS_PMP") {
         cout << "VNS heuristic - PMP\n";
         cout << "-------------------------------------------------\n";
         VNS heuristic(instance, config.seed);
         heuristic.setCoverMode(config.cover_mode);
         heuristic.setCoverMode_n2(config.cover_mode_n2);
         heuristic.setExternalTime(external_time); // external time is not used in PMP
+        heuristic.setThreadCount(THREAD_NUMBER);
         solution = heuristic.runVNS_std(true, UB_MAX_ITER);
     } else {
         cout << "[ERROR] Method not found" << endl;
@@ -493,6 +624,7 @@ Solution_std methods_PMP(const shared_ptr<Instance>& instance, const Config& con
 Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& config, double external_time) {
     Solution_cap solution;
     Solution_MAP solution_map(instance);
+    auto eval_cache = make_shared<EvalCache>(); // shared by every search on this instance
     bool add_InitialSolution_RSSV = false;
 
     string Method = config.Method;
@@ -507,6 +639,7 @@ Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& co
         cout << "-------------------------------------------------\n";
         PMP pmp(instance, "CPMP");
         pmp.setGenerateReports(true);
+        pmp.setNameVars(config.cplex_var_names);
         pmp.setCoverModel(config.cover_mode, instance->getTypeSubarea());
         pmp.setCoverModel_n2(config.cover_mode_n2, instance->getTypeSubarea_n2());
         pmp.setTimeLimit(config.CLOCK_LIMIT_CPLEX - external_time);
@@ -533,6 +666,7 @@ Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& co
         cout << "-------------------------------------------------\n";
         PMP pmp(instance, "CPMP", true);
         pmp.setGenerateReports(true);
+        pmp.setNameVars(config.cplex_var_names);
         pmp.setCoverModel(config.cover_mode, instance->getTypeSubarea());
         pmp.setCoverModel_n2(config.cover_mode_n2, instance->getTypeSubarea_n2());
         pmp.setTimeLimit(config.CLOCK_LIMIT_CPLEX - external_time);
@@ -563,7 +697,10 @@ Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& co
         heuristic.setMethod(Method);
         heuristic.setCoverMode(config.cover_mode);
         heuristic.setCoverMode_n2(config.cover_mode_n2);
+        heuristic.setTypeEval(config.TypeEval_Cap);
         heuristic.setTimeLimit(config.CLOCK_LIMIT);
+        heuristic.setEvalCache(eval_cache);
+        heuristic.setThreadCount(THREAD_NUMBER);
         solution = heuristic.run_cap(true, UB_MAX_ITER);
     } else if (Method == "VNS_CPMP" || Method == "RSSV_VNS_CPMP") {
         cout << "VNS heuristic - cPMP\n";
@@ -575,6 +712,9 @@ Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& co
         heuristic.setCoverMode(config.cover_mode);
         heuristic.setCoverMode_n2(config.cover_mode_n2);
         heuristic.setExternalTime(external_time);
+        heuristic.setTypeEval(config.TypeEval_Cap);
+        heuristic.setEvalCache(eval_cache);
+        heuristic.setThreadCount(THREAD_NUMBER);
 
         if (add_InitialSolution_RSSV && Method == "RSSV_VNS_CPMP") {
             auto vet_locs = instance->getVotedLocs();
@@ -613,10 +753,13 @@ Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& co
         exit(1);
     }
 
+    if (eval_cache->getHits() + eval_cache->getMisses() > 0)
+        cout << "[INFO] Evaluation cache: " << eval_cache->size() << " p-sets, " << eval_cache->getHits() << " hits, " << eval_cache->getMisses() << " misses\n";
+
     if (Method != "EXACT_CPMP" && Method != "EXACT_CPMP_BIN" && Method != "RSSV_EXACT_CPMP" && Method != "RSSV_EXACT_CPMP_BIN" && Method != "GAPrelax" && Method != "GAP") {
         solution.setCoverMode(config.cover_mode);
         auto p_loc = solution.get_pLocations();
-        auto sol_best = Solution_cap(instance, p_loc, "GAPrelax", config.cover_mode);
+        auto sol_best = Solution_cap(instance, p_loc, config.TypeEval_Cap == "TRANSPORT" ? "TRANSPORT" : "GAPrelax", config.cover_mode);
         return sol_best;
     }
 
@@ -625,4 +768,99 @@ Solution_cap methods_CPMP(const shared_ptr<Instance>& instance, const Config& co
     sol_best.setCoverMode_n2(config.cover_mode_n2);
 
     return sol_best;
-}
\ No newline at end of file
+}
+/*
+ * Pipelined RSSV: the sub-PMPs are sampled on a background thread (one thread less) while
+ * the TB of the final phase runs on the provisional filtered instances it publishes.
+ * Only the latest provisional instance is kept, older ones are skipped if TB is still busy.
+ * Each stage starts from the incumbent, whose locations are added to the instance if the
+ * refreshed candidates dropped them, so the objective never gets worse from one stage to
+ * the next. The last stage runs on the final filtered instance. The stages count the time
+ * since start_time_total against CLOCK_LIMIT, so a stage started late only gets what is left.
+ */
+template <typename SolutionType>
+SolutionType runPipelinedRSSV(RSSV& metaheuristic, const function<shared_ptr<Instance>(uint_t)>& runSampling,
+                              const Config& config, shared_ptr<Instance>& final_instance,
+                              high_resolution_clock::time_point start_time_total) {
+    mutex mtx;
+    condition_variable cv;
+    shared_ptr<Instance> pending; // latest instance not yet taken by the final phase
+    bool sampling_done = false;
+
+    metaheuristic.setProvisionalCallback(RSSV_PROVISIONAL_CNT, [&](shared_ptr<Instance> provisional) {
+        {
+            lock_guard<mutex> lock(mtx);
+            pending = std::move(provisional);
+        }
+        cv.notify_one();
+    });
+    thread sampling([&]() {
+        auto filtered_instance = runSampling(max(THREAD_NUMBER - 1, 1));
+        {
+            lock_guard<mutex> lock(mtx);
+            pending = filtered_instance;
+            sampling_done = true;
+        }
+        cv.notify_one();
+    });
+
+    auto eval_cache = make_shared<EvalCache>(); // same customers in every stage
+    SolutionType incumbent;
+    bool has_incumbent = false;
+    uint_t stage = 0;
+    for (;;) {
+        shared_ptr<Instance> stage_instance;
+        bool last;
+        {
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [&]() { return pending != nullptr; });
+            stage_instance = std::move(pending);
+            pending = nullptr;
+            last = sampling_done;
+        }
+
+        if (has_incumbent) {
+            auto locations = stage_instance->getLocations();
+            unordered_set<uint_t> candidates(locations.begin(), locations.end());
+            auto cnt = locations.size();
+            for (auto loc : incumbent.get_pLocations())
+                if (candidates.find(loc) == candidates.end()) locations.push_back(loc);
+            if (locations.size() != cnt) {
+                auto voted_locs = stage_instance->getVotedLocs();
+                auto threshold_dist = stage_instance->get_ThresholdDist();
+                stage_instance = make_shared<Instance>(stage_instance->getReducedSubproblem(locations, stage_instance->getTypeService()));
+                stage_instance->setVotedLocs(voted_locs);
+                stage_instance->set_ThresholdDist(threshold_dist);
+            }
+        }
+        stage_instance->setCoverModel(config.cover_mode);
+        stage_instance->setCoverModel_n2(config.cover_mode_n2);
+        stage_instance->set_isWeightedObjFunc(config.IsWeighted_ObjFunc);
+
+        TB heuristic(stage_instance, config.seed);
+        heuristic.setCoverMode(config.cover_mode);
+        heuristic.setCoverMode_n2(config.cover_mode_n2);
+        heuristic.setTimeLimit(config.CLOCK_LIMIT);
+        heuristic.setExternalTime(duration<double>(high_resolution_clock::now() - start_time_total).count()); // one CLOCK_LIMIT for sampling and all stages
+        unordered_set<uint_t> p_locations;
+        if (has_incumbent) p_locations = incumbent.get_pLocations();
+        if constexpr (std::is_same_v<SolutionType, Solution_std>) {
+            heuristic.setFastSwap(config.Method_RSSV_fp == "TB_PMP_FAST");
+            incumbent = heuristic.runFrom(p_locations, config.VERBOSE, UB_MAX_ITER);
+        } else {
+            heuristic.setSolutionMap(Solution_MAP(stage_instance));
+            heuristic.setTypeEval(config.TypeEval_Cap);
+            heuristic.setEvalCache(eval_cache);
+            incumbent = heuristic.runFrom_cap(p_locations, config.VERBOSE, UB_MAX_ITER);
+        }
+        has_incumbent = true;
+        cout << "[INFO] Pipelined RSSV stage " << ++stage << (last ? " (final instance)" : "") << ": "
+             << stage_instance->getLocations().size() << " locations, objective " << incumbent.get_objective() << endl;
+        if (last) {
+            final_instance = stage_instance;
+            break;
+        }
+    }
+    sampling.join();
+    return incumbent;
+}
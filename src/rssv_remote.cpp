@@ -0,0 +1,307 @@
+#include "rssv_remote.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define TASK_SOLVE 1
+#define TASK_STOP 0
+
+/*
+ * Payload of one message, values are appended/read in order.
+ */
+class Message {
+public:
+    vector<char> data;
+    size_t pos = 0;
+
+    template <typename T>
+    void put(const T& value) {
+        auto bytes = reinterpret_cast<const char*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+    void putString(const string& value) {
+        put<uint32_t>(value.size());
+        data.insert(data.end(), value.begin(), value.end());
+    }
+    template <typename T>
+    bool get(T& value) {
+        if (pos + sizeof(T) > data.size()) return false;
+        memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+    bool getString(string& value) {
+        uint32_t size;
+        if (!get(size) || pos + size > data.size()) return false;
+        value.assign(data.data() + pos, size);
+        pos += size;
+        return true;
+    }
+};
+
+static bool sendAll(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        auto sent = send(fd, buf, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        buf += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+// no deadline by default, otherwise false (errno ETIMEDOUT) once it has passed
+static bool recvAll(int fd, char* buf, size_t len,
+                    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max()) {
+    while (len > 0) {
+        if (deadline != chrono::steady_clock::time_point::max()) {
+            auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+            pollfd pfd{fd, POLLIN, 0};
+            int ready = remaining > 0 ? poll(&pfd, 1, remaining) : 0;
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready == 0) errno = ETIMEDOUT;
+            if (ready <= 0) return false;
+        }
+        auto got = recv(fd, buf, len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        buf += got;
+        len -= got;
+    }
+    return true;
+}
+
+static bool sendMessage(int fd, const Message& msg) {
+    uint32_t len = msg.data.size();
+    return sendAll(fd, reinterpret_cast<const char*>(&len), sizeof(len)) && sendAll(fd, msg.data.data(), len);
+}
+
+static bool recvMessage(int fd, Message& msg,
+                        chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max()) {
+    uint32_t len;
+    if (!recvAll(fd, reinterpret_cast<char*>(&len), sizeof(len), deadline)) return false;
+    msg.data.resize(len);
+    msg.pos = 0;
+    return recvAll(fd, msg.data.data(), len, deadline);
+}
+
+/*
+ * Socket for "unix:<path>" or "<host>:<port>", bound and listening if listening is set,
+ * connected otherwise. Returns -1 on failure.
+ */
+static int openSocket(const string& address, bool listening) {
+    if (address.rfind("unix:", 0) == 0) {
+        auto path = address.substr(5);
+        sockaddr_un addr{};
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            cout << "[ERROR] Invalid Unix socket path: " << path << endl;
+            return -1;
+        }
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (listening) {
+            unlink(path.c_str());
+            if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 && ::listen(fd, SOMAXCONN) == 0) return fd;
+        } else if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            return fd;
+        }
+        ::close(fd);
+        return -1;
+    }
+
+    auto colon = address.rfind(':');
+    if (colon == string::npos) {
+        cout << "[ERROR] Invalid address (unix:<path> or <host>:<port>): " << address << endl;
+        return -1;
+    }
+    auto host = address.substr(0, colon), port = address.substr(colon + 1);
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (listening) hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &res) != 0) {
+        cout << "[ERROR] Cannot resolve address: " << address << endl;
+        return -1;
+    }
+    int fd = -1;
+    for (auto ai = res; ai != nullptr && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        if (listening) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, SOMAXCONN) == 0) break;
+        } else if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // small request/reply messages
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static void putSetup(Message& msg, const RemoteSetup& setup) {
+    msg.put<uint32_t>(RSSV_REMOTE_MAGIC);
+    msg.put(setup.N);
+    msg.put(setup.customers);
+    msg.put(setup.p);
+    msg.put(setup.n);
+    msg.put(setup.seed_rssv);
+    msg.put(setup.is_cap);
+    msg.put(setup.cover_mode);
+    msg.put(setup.cover_mode_n2);
+    msg.put(setup.weighted_obj);
+    msg.put(setup.max_ite);
+    msg.put(setup.time_limit);
+    msg.putString(setup.method_sp);
+    msg.putString(setup.type_eval);
+}
+
+RemoteWorkers::~RemoteWorkers() {
+    close();
+}
+
+uint_t RemoteWorkers::listen(const string& address, uint_t cnt, const RemoteSetup& setup) {
+    int listen_fd = openSocket(address, true);
+    if (listen_fd < 0) {
+        cout << "[ERROR] Cannot listen on " << address << ": " << strerror(errno) << endl;
+        return 0;
+    }
+    cout << "Waiting for " << cnt << " RSSV workers on " << address << "..." << endl;
+
+    Message setup_msg;
+    putSetup(setup_msg, setup);
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(RSSV_CONNECT_TIMEOUT);
+    while (fds.size() < cnt) {
+        auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        pollfd pfd{listen_fd, POLLIN, 0};
+        if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0) break;
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+        if (address.rfind("unix:", 0) != 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        Message reply;
+        uint32_t accepted = 0;
+        if (!sendMessage(fd, setup_msg) || !recvMessage(fd, reply) || !reply.get(accepted) || !accepted) {
+            cout << "[WARN] RSSV worker rejected the setup (different instance?)" << endl;
+            ::close(fd);
+            continue;
+        }
+        fds.push_back(fd);
+        cout << "[INFO] RSSV worker " << fds.size() << "/" << cnt << " connected" << endl;
+    }
+    ::close(listen_fd);
+    if (address.rfind("unix:", 0) == 0) unlink(address.substr(5).c_str());
+    if (fds.size() < cnt) cout << "[WARN] Only " << fds.size() << " of " << cnt << " RSSV workers connected" << endl;
+    return fds.size();
+}
+
+void RemoteWorkers::setReplyTimeout(double seconds) {
+    reply_timeout = seconds;
+}
+
+bool RemoteWorkers::solve(uint_t k, int seed, RemoteResult& result) {
+    if (fds[k] < 0) return false;
+    Message task, reply;
+    task.put<uint32_t>(TASK_SOLVE);
+    task.put(seed);
+    uint32_t solved = 0, cnt = 0;
+    auto deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(reply_timeout));
+    errno = 0;
+    bool ok = sendMessage(fds[k], task) && recvMessage(fds[k], reply, deadline) &&
+              reply.get(result.seed) && reply.get(solved) && reply.get(result.time) &&
+              reply.get(result.max_dist) && reply.get(result.min_dist) && reply.get(result.avg_dist) &&
+              reply.get(result.std_dev_dist) && reply.get(cnt) && result.seed == seed;
+    result.p_locations.resize(cnt);
+    for (uint_t i = 0; ok && i < cnt; i++) ok = reply.get(result.p_locations[i]);
+    if (!ok) {
+        if (errno == ETIMEDOUT) cout << "[WARN] RSSV worker " << k + 1 << " sent no reply in " << reply_timeout << "s" << endl;
+        ::close(fds[k]);
+        fds[k] = -1;
+        return false;
+    }
+    result.solved = solved;
+    return true;
+}
+
+void RemoteWorkers::close() {
+    Message stop;
+    stop.put<uint32_t>(TASK_STOP);
+    stop.put<int>(0);
+    for (auto& fd : fds) {
+        if (fd < 0) continue;
+        sendMessage(fd, stop);
+        ::close(fd);
+        fd = -1;
+    }
+    fds.clear();
+}
+
+// the coordinator may not listen yet, retry until RSSV_CONNECT_TIMEOUT
+int connectCoordinator(const string& address) {
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(RSSV_CONNECT_TIMEOUT);
+    for (;;) {
+        int fd = openSocket(address, false);
+        if (fd >= 0) return fd;
+        if (chrono::steady_clock::now() >= deadline) {
+            cout << "[ERROR] Cannot connect to the RSSV coordinator on " << address << endl;
+            return -1;
+        }
+        this_thread::sleep_for(chrono::milliseconds(200));
+    }
+}
+
+bool recvSetup(int fd, RemoteSetup& setup) {
+    Message msg;
+    uint32_t magic = 0;
+    return recvMessage(fd, msg) && msg.get(magic) && magic == RSSV_REMOTE_MAGIC &&
+           msg.get(setup.N) && msg.get(setup.customers) && msg.get(setup.p) && msg.get(setup.n) &&
+           msg.get(setup.seed_rssv) && msg.get(setup.is_cap) && msg.get(setup.cover_mode) &&
+           msg.get(setup.cover_mode_n2) && msg.get(setup.weighted_obj) && msg.get(setup.max_ite) &&
+           msg.get(setup.time_limit) && msg.getString(setup.method_sp) && msg.getString(setup.type_eval);
+}
+
+bool sendSetupReply(int fd, bool accepted) {
+    Message msg;
+    msg.put<uint32_t>(accepted);
+    return sendMessage(fd, msg);
+}
+
+bool recvTask(int fd, int& seed) {
+    Message msg;
+    uint32_t type = TASK_STOP;
+    return recvMessage(fd, msg) && msg.get(type) && msg.get(seed) && type == TASK_SOLVE;
+}
+
+bool sendResult(int fd, const RemoteResult& result) {
+    Message msg;
+    msg.put(result.seed);
+    msg.put<uint32_t>(result.solved);
+    msg.put(result.time);
+    msg.put(result.max_dist);
+    msg.put(result.min_dist);
+    msg.put(result.avg_dist);
+    msg.put(result.std_dev_dist);
+    msg.put<uint32_t>(result.p_locations.size());
+    for (auto loc : result.p_locations) msg.put(loc);
+    return sendMessage(fd, msg);
+}
+
+void closeConnection(int fd) {
+    if (fd >= 0) ::close(fd);
+}
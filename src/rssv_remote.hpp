@@ -0,0 +1,84 @@
+#ifndef LARGE_PMP_RSSV_REMOTE_HPP
+#define LARGE_PMP_RSSV_REMOTE_HPP
+
+#include <string>
+#include <vector>
+#include "globals.hpp"
+
+using namespace std;
+
+#define RSSV_REMOTE_MAGIC 0x52535356u // "RSSV"
+#define RSSV_CONNECT_TIMEOUT 120 // s, coordinator waiting for its workers / worker waiting for the coordinator
+#define RSSV_REPLY_FACTOR 2      // a worker is given up after RSSV_REPLY_FACTOR * sub-PMP time limit + RSSV_REPLY_MARGIN
+#define RSSV_REPLY_MARGIN 60     // s
+#define RSSV_REPLY_TIMEOUT 7200  // s, reply wait for sub-PMPs without a time limit
+
+/*
+ * Coordinator/worker RSSV over sockets, the address is "unix:<path>" (Unix domain socket)
+ * or "<host>:<port>" (TCP). The coordinator listens and sends every worker the settings of
+ * the sub-PMPs; a worker loads the same instance (a binary instance is mmapped, so local
+ * workers share its pages), then solves the sub-PMPs whose seeds it receives one at a time
+ * and streams back only their p-sets. Sampling a sub-PMP only depends on its seed, so no
+ * locations are sent to the worker. Messages are length-prefixed, in the native byte order.
+ */
+
+// sub-PMP settings of the coordinator, sent to each worker once connected
+struct RemoteSetup {
+    uint_t N = 0;         // locations, customers and p are checked against the worker's instance
+    uint_t customers = 0;
+    uint_t p = 0;
+    uint_t n = 0;         // sub-PMP size
+    int seed_rssv = 0;
+    bool is_cap = false;
+    bool cover_mode = false;
+    bool cover_mode_n2 = false;
+    bool weighted_obj = false;
+    uint_t max_ite = 0;
+    double time_limit = 0;
+    string method_sp;
+    string type_eval;
+};
+
+// one sub-PMP solved by a worker
+struct RemoteResult {
+    int seed = 0;
+    bool solved = false; // false if the worker hit the time limit
+    double time = 0;     // s
+    dist_t max_dist = 0, min_dist = 0, avg_dist = 0, std_dev_dist = 0;
+    vector<uint_t> p_locations;
+};
+
+// coordinator side, one connection per worker
+class RemoteWorkers {
+public:
+    RemoteWorkers() = default;
+    ~RemoteWorkers();
+    RemoteWorkers(const RemoteWorkers&) = delete;
+    RemoteWorkers& operator=(const RemoteWorkers&) = delete;
+
+    // wait (at most RSSV_CONNECT_TIMEOUT) for cnt workers, returns the no. connected
+    uint_t listen(const string& address, uint_t cnt, const RemoteSetup& setup);
+    // longest wait for the reply to a sub-PMP, a worker that exceeds it is given up
+    void setReplyTimeout(double seconds);
+    // solve a sub-PMP on worker k, false if the worker is gone or does not reply in time
+    bool solve(uint_t k, int seed, RemoteResult& result);
+    // tell the workers to stop and close the connections
+    void close();
+    uint_t size() const {
+        return fds.size();
+    }
+
+private:
+    vector<int> fds; // -1 once a worker is gone
+    double reply_timeout = RSSV_REPLY_TIMEOUT; // s
+};
+
+// worker side
+int connectCoordinator(const string& address);
+bool recvSetup(int fd, RemoteSetup& setup);
+bool sendSetupReply(int fd, bool accepted);
+bool recvTask(int fd, int& seed); // false on stop or a closed connection
+bool sendResult(int fd, const RemoteResult& result);
+void closeConnection(int fd);
+
+#endif //LARGE_PMP_RSSV_REMOTE_HPP
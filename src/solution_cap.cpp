@@ -2,6 +2,7 @@
 #include "solution_cap.hpp"
 #include "globals.hpp"
 #include "PMP.hpp"
+#include "transport.hpp"
 #include <iomanip>
 #include <utility>
 #include <experimental/filesystem>
@@ -16,7 +17,7 @@ Solution_cap::Solution_cap(shared_ptr<Instance> instance, unordered_set<uint_t>
     this->typeEval = typeEval;
 
     // cout << "typeEval: " << typeEval << endl;
-    if (strcmp(typeEval, "GAP") == 0 || strcmp(typeEval, "GAPrelax") == 0){
+    if (strcmp(typeEval, "GAP") == 0 || strcmp(typeEval, "GAPrelax") == 0 || strcmp(typeEval, "TRANSPORT") == 0){
         GAP_eval(); 
     }else if(strcmp(typeEval, "heuristic") == 0){
         fullCapEval(); // urgency priority heuristic
@@ -28,46 +29,114 @@ Solution_cap::Solution_cap(shared_ptr<Instance> instance, unordered_set<uint_t>
 
 Solution_cap::Solution_cap(shared_ptr<Instance> instance,
                  unordered_set<uint_t> p_locations,
-                 unordered_map<uint_t, dist_t> loc_usages, 
-                 unordered_map<uint_t, dist_t> cust_satisfactions, 
-                 unordered_map<uint_t, assignment> assignments) {
+                 shared_ptr<CapAssignment> assign) {
     this->instance = std::move(instance);
     this->p_locations = std::move(p_locations);
-    this->loc_usages = std::move(loc_usages);
-    this->cust_satisfactions = std::move(cust_satisfactions);
-    this->assignments = std::move(assignments);
+    this->assign = std::move(assign);
     this->typeEval = "CPLEX";
     objEval();
     // GAP_eval();
 }
 
+CapAssignment::CapAssignment(uint_t loc_cnt, uint_t cust_cnt)
+        : loc_usages(loc_cnt, 0), cust_satisfactions(cust_cnt, 0), offsets(cust_cnt + 1, 0) {}
+
+// usage counted at once in loc_usages/cust_satisfactions, the entry is visible after pack()
+void CapAssignment::add(uint_t cust_index, uint_t loc_index, const my_tuple& entry) {
+    if (loc_index != NO_INDEX) loc_usages[loc_index] += entry.usage;
+    cust_satisfactions[cust_index] += entry.usage;
+    staged.emplace_back(cust_index, entry);
+}
+
+// Merge the staged entries into the CSR arrays, keeping the order of the entries per customer
+void CapAssignment::pack() {
+    if (staged.empty()) return;
+    uint_t cust_cnt = offsets.size() - 1;
+    vector<uint_t> new_offsets(cust_cnt + 1, 0);
+    for (uint_t i = 0; i < cust_cnt; i++) new_offsets[i + 1] = offsets[i + 1] - offsets[i];
+    for (auto& e : staged) new_offsets[e.first + 1]++;
+    for (uint_t i = 0; i < cust_cnt; i++) new_offsets[i + 1] += new_offsets[i];
+
+    vector<my_tuple> new_entries(new_offsets[cust_cnt]);
+    vector<uint_t> next(new_offsets.begin(), new_offsets.end() - 1); // customer index -> next free entry
+    for (uint_t i = 0; i < cust_cnt; i++)
+        for (auto k = offsets[i]; k < offsets[i + 1]; k++) new_entries[next[i]++] = entries[k];
+    for (auto& e : staged) new_entries[next[e.first]++] = e.second;
+
+    offsets.swap(new_offsets);
+    entries.swap(new_entries);
+    staged.clear();
+}
+
+// Replace the entries of one customer (usages and satisfactions are left as they are)
+void CapAssignment::setEntries(uint_t cust_index, const assignment& new_entries) {
+    pack();
+    auto first = entries.begin() + offsets[cust_index];
+    auto last = entries.begin() + offsets[cust_index + 1];
+    int diff = int(new_entries.size()) - int(last - first);
+    entries.insert(entries.erase(first, last), new_entries.begin(), new_entries.end());
+    for (auto i = cust_index + 1; i < offsets.size(); i++) offsets[i] += diff;
+}
+
+// the assignment of this solution only, copied first if another solution shares it
+CapAssignment& Solution_cap::mutableAssignment() {
+    if (!assign) assign = make_shared<CapAssignment>(instance->getLocations().size(), instance->getCustomers().size());
+    else if (assign.use_count() > 1) assign = make_shared<CapAssignment>(*assign);
+    return *assign;
+}
+
+
+vector<pair<uint_t, uint_t>> Solution_cap::pLocIndexes() const {
+    vector<pair<uint_t, uint_t>> p_indexes;
+    p_indexes.reserve(p_locations.size());
+    for (auto loc:p_locations) p_indexes.emplace_back(loc, instance->getLocIndex(loc));
+    return p_indexes;
+}
+
+// location index of an assigned location, p_sorted is pLocIndexes() sorted by location
+static uint_t findLocIndex(const vector<pair<uint_t, uint_t>>& p_sorted, uint_t loc, Instance& instance) {
+    auto it = lower_bound(p_sorted.begin(), p_sorted.end(), make_pair(loc, uint_t(0)));
+    if (it == p_sorted.end() || it->first != loc) return instance.getLocIndex(loc); // set by setAssigment
+    return it->second;
+}
 
 void Solution_cap::naiveEval() {
 //    assert(p_locations.size() == instance->get_p());
     objective = 0;
-    for (auto cust:instance->getCustomers()) {
-        auto loc = getClosestpLoc(cust);
-        auto dist = instance->getWeightedDist(loc, cust);
+    const auto& customers = instance->getCustomers();
+    assign = make_shared<CapAssignment>(instance->getLocations().size(), customers.size());
+    auto p_indexes = pLocIndexes();
+    for (uint_t i = 0; i < customers.size(); i++) {
+        auto [loc, loc_index] = p_indexes[closestpLocByIdx(i, p_indexes)];
+        auto dist = instance->weightByIdx(i) * instance->distByIdx(loc_index, i);
         objective += dist;
-        assignments[cust].emplace_back(my_tuple{loc, 0, dist});
+        assign->add(i, loc_index, my_tuple{loc, 0, dist});
         // assignment[cust] = my_pair{loc, dist};
 //        cout << cust << " " << assignment[cust].node << " " << assignment[cust].dist << endl;
     }
+    assign->pack();
 }
 
 uint_t Solution_cap::getClosestpLoc(uint_t cust) {
+    auto p_indexes = pLocIndexes();
+    auto pos = closestpLocByIdx(instance->getCustIndex(cust), p_indexes);
+    return pos == NO_INDEX ? numeric_limits<uint_t>::max() : p_indexes[pos].first;
+}
+
+uint_t Solution_cap::closestpLocByIdx(uint_t cust_index, const vector<pair<uint_t, uint_t>>& p_indexes) {
+    bool is_weighted_obj_func = instance->get_isWeightedObjFunc();
     dist_t dist_min = numeric_limits<dist_t>::max();
-    uint_t loc_closest = numeric_limits<uint_t>::max();
-    for (auto loc:p_locations) {
-        dist_t dist =  instance->getRealDist(loc, cust);
-        if(instance->get_isWeightedObjFunc()) dist = instance->getWeightedDist(loc, cust);
+    uint_t pos_closest = NO_INDEX;
+    for (uint_t pos = 0; pos < p_indexes.size(); pos++) {
+        dist_t dist = instance->distByIdx(p_indexes[pos].second, cust_index);
+        if (is_weighted_obj_func) dist *= instance->weightByIdx(cust_index);
         if (dist <= dist_min) {
             dist_min = dist;
-            loc_closest = loc;
+            pos_closest = pos;
         }
     }
 
-    return loc_closest;
+    return pos_closest;
 }
 
 // Function to check if the target value is in the first element of any pair in the vector
@@ -87,18 +156,23 @@ vector<pair<uint_t, dist_t>> Solution_cap::getUrgencies() {
     vector<pair<uint_t, dist_t>> urgencies_vec;
 
     // get closest and second closest p location with some remaining capacity
-    for (auto p:cust_satisfactions) {
-        auto cust = p.first;
-        auto sat = p.second; // cust satisfaction                              
+    const auto& customers = instance->getCustomers();
+    auto p_indexes = pLocIndexes();
+    auto distPos = [&](uint_t pos, uint_t i) {
+        return pos == NO_INDEX ? DEFAULT_DISTANCE : instance->distByIdx(p_indexes[pos].second, i);
+    };
+    for (uint_t i = 0; i < customers.size(); i++) {
+        auto cust = customers[i];
+        auto sat = assign->cust_satisfactions[i]; // cust satisfaction                              
         // auto dem = instance->getCustWeight(cust) - sat;     // cust remaining demand
-        auto dem = instance->getCustWeight(cust);     // cust remaining demand
+        auto dem = instance->weightByIdx(i);     // cust remaining demand
 
         // if (sat < dem) { // cust not fully satisfied yet
         if (dem - sat > 0) { // cust not fully satisfied yet
-            auto l1 = getClosestOpenpLoc(cust, numeric_limits<uint_t>::max());
-            auto l2 = getClosestOpenpLoc(cust, l1);
-            auto dist1 = instance->getRealDist(l1, cust);
-            auto dist2 = instance->getRealDist(l2, cust);
+            auto l1 = closestOpenpLocByIdx(i, NO_INDEX, p_indexes);
+            auto l2 = closestOpenpLocByIdx(i, l1, p_indexes);
+            auto dist1 = distPos(l1, i);
+            auto dist2 = distPos(l2, i);
             dist_t urgency = fabs(dist1 - dist2);
             urgencies_vec.emplace_back(make_pair(cust, urgency));
         }
@@ -115,11 +189,7 @@ void Solution_cap::fullCapEval() {
     // Initialize all fields
     bool is_weighted_obj_func = instance->get_isWeightedObjFunc();
     objective = 0;
-    for (auto p_loc:this->p_locations) loc_usages[p_loc] = 0;
-    for (auto cust:this->instance->getCustomers()) {
-        cust_satisfactions[cust] = 0;
-        assignments[cust] = assignment{};
-    }
+    assign = make_shared<CapAssignment>(instance->getLocations().size(), instance->getCustomers().size());
 
     // Check if capacity demands can be met
     uint_t total_capacity = 0;
@@ -143,6 +213,7 @@ void Solution_cap::fullCapEval() {
 
 
     // Determine unassigned customer's urgencies
+    auto p_indexes = pLocIndexes();
     auto urgencies_vec = getUrgencies();
     bool location_full = false;
     bool infeasible = false;
@@ -153,15 +224,16 @@ void Solution_cap::fullCapEval() {
         // Assign customers, until some capacity is full
         for (auto p:urgencies_vec) {
             auto cust = p.first;
-            auto dem_rem = instance->getCustWeight(cust) - cust_satisfactions[cust]; // remaining demand
+            auto cust_index = instance->getCustIndex(cust);
+            auto dem_rem = instance->weightByIdx(cust_index) - assign->cust_satisfactions[cust_index]; // remaining demand
 
             cont_iter++;
             // cout << "cont_iter: " << cont_iter << endl;
             // cout << "\n\ncust: " << cust << " dem_rem: " << dem_rem << endl;
 
             while (dem_rem > 0  && !infeasible) {
-                auto loc = getClosestOpenpLoc(cust, numeric_limits<uint_t>::max());
-                if (loc == numeric_limits<uint_t>::max()) {
+                auto pos = closestOpenpLocByIdx(cust_index, NO_INDEX, p_indexes);
+                if (pos == NO_INDEX) {
                     cerr << "Assignment not possible\n";
                     infeasible = true;
                     cont++; 
@@ -170,28 +242,25 @@ void Solution_cap::fullCapEval() {
                     // exit(1);
                     // break;
                 }else{
-                    auto cap_rem = instance->getLocCapacity(loc) - loc_usages[loc];
+                    auto [loc, loc_index] = p_indexes[pos];
+                    auto cap_rem = instance->capacityByIdx(loc_index) - assign->loc_usages[loc_index];
                     if (dem_rem > cap_rem) { // assign all remaining location capacity
-                        loc_usages[loc] += cap_rem;
-                        cust_satisfactions[cust] += cap_rem;
                         
                         
-                        auto obj_increment =  instance->getRealDist(loc, cust);
-                        if(is_weighted_obj_func){obj_increment =  cap_rem * instance->getRealDist(loc, cust);}
+                        auto obj_increment =  instance->distByIdx(loc_index, cust_index);
+                        if(is_weighted_obj_func){obj_increment =  cap_rem * instance->distByIdx(loc_index, cust_index);}
 
                         // objective += obj_increment;
-                        assignments[cust].emplace_back(my_tuple{loc, cap_rem, obj_increment});
+                        assign->add(cust_index, loc_index, my_tuple{loc, cap_rem, obj_increment});
                         dem_rem -= cap_rem;
                         location_full = true;
 
                         break;
                     } else { // assign dem_rem
-                        loc_usages[loc] += dem_rem;
-                        cust_satisfactions[cust] += dem_rem;
-                        auto obj_increment = instance->getRealDist(loc, cust);
-                        if(is_weighted_obj_func){obj_increment =  dem_rem * instance->getRealDist(loc, cust);}
+                        auto obj_increment = instance->distByIdx(loc_index, cust_index);
+                        if(is_weighted_obj_func){obj_increment =  dem_rem * instance->distByIdx(loc_index, cust_index);}
                         // objective += obj_increment;
-                        assignments[cust].emplace_back(my_tuple{loc, dem_rem, obj_increment});
+                        assign->add(cust_index, loc_index, my_tuple{loc, dem_rem, obj_increment});
                         dem_rem = 0;
                     }
                 }
@@ -206,6 +275,7 @@ void Solution_cap::fullCapEval() {
 
     }
 
+    assign->pack();
     isFeasible = !infeasible;
     // cout << "fullCapEval: " << objective << endl;
     if (isFeasible) objEval();
@@ -225,17 +295,26 @@ void Solution_cap::fullCapEval() {
 }
 
 uint_t Solution_cap::getClosestOpenpLoc(uint_t cust, uint_t forbidden_loc) {
+    auto p_indexes = pLocIndexes();
+    uint_t forbidden_pos = NO_INDEX;
+    for (uint_t pos = 0; pos < p_indexes.size(); pos++)
+        if (p_indexes[pos].first == forbidden_loc) forbidden_pos = pos;
+    auto pos = closestOpenpLocByIdx(instance->getCustIndex(cust), forbidden_pos, p_indexes);
+    return pos == NO_INDEX ? numeric_limits<uint_t>::max() : p_indexes[pos].first;
+}
+
+uint_t Solution_cap::closestOpenpLocByIdx(uint_t cust_index, uint_t forbidden_pos, const vector<pair<uint_t, uint_t>>& p_indexes) {
     dist_t dist_min = numeric_limits<dist_t>::max();
-    dist_t dist;
-    uint_t loc_closest = numeric_limits<uint_t>::max();
-    for (auto loc:p_locations) {
-        dist = instance->getRealDist(loc, cust);
-        if (dist <= dist_min && loc_usages[loc] < instance->getLocCapacity(loc) && loc != forbidden_loc) {
+    uint_t pos_closest = NO_INDEX;
+    for (uint_t pos = 0; pos < p_indexes.size(); pos++) {
+        auto loc_index = p_indexes[pos].second;
+        dist_t dist = instance->distByIdx(loc_index, cust_index);
+        if (dist <= dist_min && assign->loc_usages[loc_index] < instance->capacityByIdx(loc_index) && pos != forbidden_pos) {
             dist_min = dist;
-            loc_closest = loc;
+            pos_closest = pos;
         }
     }
-    return loc_closest;
+    return pos_closest;
 }
 
 void Solution_cap::print() {
@@ -278,11 +357,26 @@ void Solution_cap::replaceLocation(uint_t loc_old, uint_t loc_new, const char* t
         p_locations.erase(loc_old);
         p_locations.insert(loc_new);
 
-        if (strcmp(typeEVAL, "GAP") == 0 || strcmp(typeEVAL, "GAPrelax") == 0){
+        if (strcmp(typeEVAL, "TRANSPORT") == 0 && transport){
+            // warm start from the flow of this solution, the copy keeps the shared one intact
+            transport = make_shared<Transport>(*transport);
+            transport->setUpperBound(UpperBound);
+            if (transport->replaceFacility(loc_old, loc_new)){
+                isFeasible = true;
+                assign = transport->getAssignment();
+                objective = transport->getObjective();
+            }else{
+                objective=numeric_limits<dist_t>::max();
+                isFeasible = false;
+                transport = nullptr;
+            }
+        }else if (strcmp(typeEVAL, "GAP") == 0 || strcmp(typeEVAL, "GAPrelax") == 0 || strcmp(typeEVAL, "TRANSPORT") == 0){
             GAP_eval(); 
         }else if(strcmp(typeEVAL, "heuristic") == 0){
+            transport = nullptr;
             fullCapEval(); // urgency priority heuristic
         }else if (strcmp(typeEVAL, "naive") == 0 || strcmp(typeEVAL, "PMP") == 0){
+            transport = nullptr;
             naiveEval();
         }else{
             cerr << "ERROR: typeEVAL not recognized" << endl;
@@ -372,13 +466,14 @@ void Solution_cap::saveAssignment(string output_filename, string Method, double
 
     cout << "LOCATION USAGES\nlocation (usage/capacity)\n";
     for (auto p_loc:p_locations)
-        cout << p_loc << " (" << loc_usages[p_loc] << "/" << instance->getLocCapacity(p_loc) << ")\n";
+        cout << p_loc << " (" << assign->loc_usages[instance->getLocIndex(p_loc)] << "/" << instance->getLocCapacity(p_loc) << ")\n";
     cout << endl;
 
     cout << "CUSTOMER ASSIGNMENTS\ncustomer (demand) -> location (assigned demand)\n";
-    for (auto cust:instance->getCustomers()) {
-        cout << cust << " (" << instance->getCustWeight(cust) << ") -> ";
-        for (auto a:assignments[cust]) cout << a.node << " (" << a.usage << ") ";
+    const auto& customers = instance->getCustomers();
+    for (uint_t i = 0; i < customers.size(); i++) {
+        cout << customers[i] << " (" << instance->weightByIdx(i) << ") -> ";
+        for (auto a:assign->getEntries(i)) cout << a.node << " (" << a.usage << ") ";
         cout << endl;
     }
     cout << endl;
@@ -505,75 +600,57 @@ uint_t Solution_cap::getTotalCapacity() {
     return total_cap;
 }
 
-unordered_map<uint_t, dist_t>  Solution_cap::getLocUsages(){
-    return loc_usages;
-}
-unordered_map<uint_t, dist_t> Solution_cap::getCustSatisfactions(){
-    return cust_satisfactions;
-}
-unordered_map<uint_t, assignment> Solution_cap::getAssignments(){
-    return assignments;
+const CapAssignment& Solution_cap::getCapAssignment() const {
+    return *assign;
 }
 
 
 void Solution_cap::setLocUsage(uint_t loc, dist_t usage){
+    transport = nullptr; // flow no longer matches
 
     if (usage > instance->getLocCapacity(loc)){
         cerr << "ERROR: usage > capacity" << endl;
         exit(1);
     }   
-    loc_usages[loc] = usage;
+    mutableAssignment().loc_usages[instance->getLocIndex(loc)] = usage;
     objEval();
 }
 
 void Solution_cap::setCustSatisfaction(uint_t cust, dist_t satisfaction){
+    transport = nullptr; // flow no longer matches
 
     if (satisfaction > instance->getCustWeight(cust)){
         cerr << "ERROR: satisfaction > weight" << endl;
         exit(1);
     }   
-    cust_satisfactions[cust] = satisfaction;
+    mutableAssignment().cust_satisfactions[instance->getCustIndex(cust)] = satisfaction;
     objEval();
 }
 
 void Solution_cap::setAssigment(uint_t cust, assignment assigment){
-    assignments[cust] = assigment;
+    transport = nullptr; // flow no longer matches
+    mutableAssignment().setEntries(instance->getCustIndex(cust), assigment);
     objEval();
 }
 
-void Solution_cap::setSolution(shared_ptr<Instance> instance, unordered_set<uint_t> p_locations
-                    ,unordered_map<uint_t, dist_t> loc_usages, unordered_map<uint_t, dist_t> cust_satisfactions
-                    ,unordered_map<uint_t, assignment> assignments, dist_t objective){
-    this->instance = instance;
-    this->p_locations = p_locations;
-    this->loc_usages = loc_usages;
-    this->cust_satisfactions = cust_satisfactions;
-    this->assignments = assignments;
-    this->objective = objective;    
-    // objEval();
-}
-
 void Solution_cap::GAP_eval(){
     // Initialize all fields
     // bool is_weighted_obj_func = instance->get_isWeightedObjFunc();;
     objective = 0;
-    for (auto p_loc:this->p_locations) loc_usages[p_loc] = 0;
-    for (auto cust:this->instance->getCustomers()) {
-        cust_satisfactions[cust] = 0;
-        assignments[cust] = assignment{};
-    }
+    assign = make_shared<CapAssignment>(instance->getLocations().size(), instance->getCustomers().size());
 
     if (strcmp(typeEval, "GAP") == 0){
-        PMP pmp(instance, "GAP", true);
-        if (UpperBound > 0) pmp.setUpperBound(UpperBound);
+        auto pmp = getGAPModel(true);
+        pmp->setUpperBound(UpperBound);
         // pmp.setCoverMode(cover_mode);
-        pmp.run_GAP(p_locations);
+        pmp->run_GAP(p_locations);
         // auto sol_gap = pmp.getSolution_cap();
-        if (pmp.getFeasibility_Solver()){
+        if (pmp->getFeasibility_Solver()){
             isFeasible = true;  
-            auto sol_gap = pmp.getSolution_cap();
-            setSolution(instance, sol_gap.get_pLocations(), sol_gap.getLocUsages(),
-                sol_gap.getCustSatisfactions(), sol_gap.getAssignments(), sol_gap.get_objective());
+            auto sol_gap = pmp->getSolution_cap();
+            p_locations = sol_gap.p_locations;
+            assign = sol_gap.assign;
+            objective = sol_gap.objective;
         }else{
             objective=numeric_limits<dist_t>::max();
             // cout << "GAP not feasible" << endl;
@@ -582,18 +659,19 @@ void Solution_cap::GAP_eval(){
         }
     }
     if (strcmp(typeEval, "GAPrelax") == 0){
-        PMP pmp(instance, "GAP", false);
+        auto pmp = getGAPModel(false);
         // pmp.setCoverMode(cover_mode);
-        if (UpperBound > 0) pmp.setUpperBound(UpperBound);
-        pmp.run_GAP(p_locations);
+        pmp->setUpperBound(UpperBound);
+        pmp->run_GAP(p_locations);
         // auto sol_gap = pmp.getSolution_cap();
-        if (pmp.getFeasibility_Solver()){
+        if (pmp->getFeasibility_Solver()){
             isFeasible = true;
-            auto sol_gap = pmp.getSolution_cap();
+            auto sol_gap = pmp->getSolution_cap();
             // sol_gap.print();
             // sol_gap.saveAssignment("GAP_intern", "GAP");
-            setSolution(instance, sol_gap.get_pLocations(), sol_gap.getLocUsages(),
-                sol_gap.getCustSatisfactions(), sol_gap.getAssignments(), sol_gap.get_objective());
+            p_locations = sol_gap.p_locations;
+            assign = sol_gap.assign;
+            objective = sol_gap.objective;
         }else{
             objective=numeric_limits<dist_t>::max();
             // cout << "GAPrelax not feasible" << endl;
@@ -601,6 +679,26 @@ void Solution_cap::GAP_eval(){
             isFeasible = false;
         }
     }
+    transport = nullptr;
+    if (strcmp(typeEval, "TRANSPORT") == 0){ // GAPrelax solved as a transportation problem, no CPLEX
+        transport = make_shared<Transport>(instance, p_locations);
+        if (UpperBound > 0) transport->setUpperBound(UpperBound);
+        if (transport->run()){
+            isFeasible = true;
+            assign = transport->getAssignment();
+            objective = transport->getObjective();
+        }else{
+            objective=numeric_limits<dist_t>::max();
+            isFeasible = false;
+            transport = nullptr;
+        }
+    }
+}
+
+// the shared GAP model if it matches the evaluation (binary or relaxed x), otherwise a model built for this call only
+shared_ptr<PMP> Solution_cap::getGAPModel(bool is_BinModel){
+    if (gap_model != nullptr && gap_model->is_BinModel == is_BinModel) return gap_model;
+    return make_shared<PMP>(instance, "GAP", is_BinModel);
 }
 
 void Solution_cap::objEval(){
@@ -609,12 +707,16 @@ void Solution_cap::objEval(){
 
     this->objective = 0;
     dist_t obj_value = 0.0;
-    for (auto cust:instance->getCustomers()) {
-        for (auto a:assignments[cust]){ 
+    const auto& customers = instance->getCustomers();
+    auto p_sorted = pLocIndexes();
+    sort(p_sorted.begin(), p_sorted.end());
+    for (uint_t i = 0; i < customers.size(); i++) {
+        for (auto a:assign->getEntries(i)){ 
+            auto dist = instance->distByIdx(findLocIndex(p_sorted, a.node, *instance), i);
             // a.usage = wi * xij 
-            if(is_weighted_obj_func){obj_value += a.usage * instance->getRealDist(a.node, cust);}
+            if(is_weighted_obj_func){obj_value += a.usage * dist;}
             // xij = a.usage/wi
-            else{obj_value += (a.usage/instance->getCustWeight(cust)) * instance->getRealDist(a.node, cust);}
+            else{obj_value += (a.usage/instance->weightByIdx(i)) * dist;}
         }
     }
     this->objective = obj_value;
@@ -629,12 +731,6 @@ void Solution_cap::setFeasibility(bool feasible){
 }
 
 
-int getIndex(vector<uint_t> vec, uint_t val){
-    auto it = find(vec.begin(), vec.end(), val);
-    if (it != vec.end()) return distance(vec.begin(), it);
-    else return -1;
-}
-
 bool Solution_cap::isSolutionFeasible(){
     
     isFeasible = true;
@@ -650,14 +746,16 @@ bool Solution_cap::isSolutionFeasible(){
         return isFeasible;
     }
     
-    auto locations = instance->getLocations();
+    const auto& locations = instance->getLocations();
+    const auto& customers = instance->getCustomers();
     vector<uint_t> vector_capacities = vector<uint_t>(locations.size(), 0);
 
-    for (auto cust:instance->getCustomers()) {
+    for (uint_t i = 0; i < customers.size(); i++) {
+        auto cust = customers[i];
         double satisfaction = 0;
-        for (auto a:assignments[cust]) {
+        for (auto a:assign->getEntries(i)) {
             satisfaction += a.usage;
-            vector_capacities[getIndex(locations, a.node)] += a.usage;
+            vector_capacities[instance->getLocIndex(a.node)] += a.usage;
             if (a.usage > instance->getLocCapacity(a.node)+0.01){
                 if (verb) cout << "ERROR: usage > capacity" << endl;
                 if (verb) cout << "usage: " << a.usage << "\n capacity: " << instance->getLocCapacity(a.node) << endl;
@@ -683,8 +781,8 @@ bool Solution_cap::isSolutionFeasible(){
     }
 
 
-    for (auto loc:instance->getLocations()) {
-        if (vector_capacities[getIndex(locations,loc)] > instance->getLocCapacity(loc)){
+    for (uint_t j = 0; j < locations.size(); j++) {
+        if (vector_capacities[j] > instance->capacityByIdx(j)){
             if (verb) cout << "ERROR: usage > capacity" << endl;
             isFeasible = false;
             return isFeasible;
@@ -717,6 +815,10 @@ void Solution_cap::add_UpperBound(double UB){
     this->UpperBound = UB;
 }   
 
+void Solution_cap::setGAPModel(shared_ptr<PMP> gap_model){
+    this->gap_model = gap_model;
+}
+
 
 void Solution_cap::statsDistances(){
     dist_t max_dist = 0;
@@ -725,9 +827,12 @@ void Solution_cap::statsDistances(){
     dist_t dist;
     uint_t cont = 0;
     
-    for (auto cust:instance->getCustomers()) {
-        for (auto a:assignments[cust]) {
-            dist = instance->getRealDist(a.node, cust);
+    const auto& customers = instance->getCustomers();
+    auto p_sorted = pLocIndexes();
+    sort(p_sorted.begin(), p_sorted.end());
+    for (uint_t i = 0; i < customers.size(); i++) {
+        for (auto a:assign->getEntries(i)) {
+            dist = instance->distByIdx(findLocIndex(p_sorted, a.node, *instance), i);
             if (dist > max_dist) max_dist = dist;
             if (dist < min_dist) min_dist = dist;
             avg_dist += dist;
@@ -741,9 +846,9 @@ void Solution_cap::statsDistances(){
     // standard deviation
     dist_t std_dev_dist = 0;
     dist_t sum = 0;
-    for (auto cust:instance->getCustomers()) {
-        for (auto a:assignments[cust]) {
-            dist = instance->getRealDist(a.node, cust);
+    for (uint_t i = 0; i < customers.size(); i++) {
+        for (auto a:assign->getEntries(i)) {
+            dist = instance->distByIdx(findLocIndex(p_sorted, a.node, *instance), i);
             sum += pow(dist - avg_dist, 2);
         }
     }
@@ -12,6 +12,39 @@
 #include "instance.hpp"
 // #include "PMP.hpp"
 
+class Transport;
+class PMP;
+
+/*
+ * Assignment of a capacitated solution as flat arrays over the indexes of the instance
+ * (getLocations() / getCustomers()). The possibly split assignment of customer i is
+ * entries[offsets[i] .. offsets[i+1]) (CSR). add() may come in any customer order, the
+ * entries wait in staged until pack() merges them.
+ */
+struct CapAssignment {
+    vector<dist_t> loc_usages;         // location index -> usage from <0, capacity>
+    vector<dist_t> cust_satisfactions; // customer index -> satisfaction from <0, weight>
+    vector<uint_t> offsets;            // customer index -> first entry, size customers + 1
+    vector<my_tuple> entries;          // (p location, usage, distance)
+    vector<pair<uint_t, my_tuple>> staged; // (customer index, entry) added since the last pack()
+
+    struct Range {
+        const my_tuple* first;
+        const my_tuple* last;
+        const my_tuple* begin() const { return first; }
+        const my_tuple* end() const { return last; }
+    };
+
+    CapAssignment() = default;
+    CapAssignment(uint_t loc_cnt, uint_t cust_cnt);
+    void add(uint_t cust_index, uint_t loc_index, const my_tuple& entry);
+    void pack();
+    void setEntries(uint_t cust_index, const assignment& new_entries);
+    Range getEntries(uint_t cust_index) const {
+        return Range{entries.data() + offsets[cust_index], entries.data() + offsets[cust_index + 1]};
+    }
+};
+
 class Solution_cap {
 private:
     unordered_set<uint_t> p_locations; // p selected locations
@@ -20,12 +53,16 @@ private:
     const char* typeEval;
 
 
-    unordered_map<uint_t, dist_t> loc_usages; // p location -> usage from <0, capacity>
-    unordered_map<uint_t, dist_t> cust_satisfactions; // customer -> satisfaction from <0, weight>
-    unordered_map<uint_t, assignment> assignments; // customer -> its current assignment (p location, usage, weighted distance)
-    void setSolution(shared_ptr<Instance> instance, unordered_set<uint_t> p_locations
-                    ,unordered_map<uint_t, dist_t>  loc_usages,unordered_map<uint_t, dist_t> cust_satisfactions
-                    ,unordered_map<uint_t, assignment> assignments, dist_t objective);
+    shared_ptr<CapAssignment> assign; // usages, satisfactions and assignments, shared between copies (copy on write)
+    shared_ptr<Transport> transport; // optimal flow of the last "TRANSPORT" evaluation, shared between copies until a swap
+    shared_ptr<PMP> gap_model; // long-lived CPLEX GAP model reused by "GAP"/"GAPrelax" evaluations, shared between copies
+    shared_ptr<PMP> getGAPModel(bool is_BinModel);
+    CapAssignment& mutableAssignment();
+    // (p location, location index) in the order of p_locations, resolved once per evaluation
+    vector<pair<uint_t, uint_t>> pLocIndexes() const;
+    // positions in p_indexes, NO_INDEX if there is none
+    uint_t closestpLocByIdx(uint_t cust_index, const vector<pair<uint_t, uint_t>>& p_indexes);
+    uint_t closestOpenpLocByIdx(uint_t cust_index, uint_t forbidden_pos, const vector<pair<uint_t, uint_t>>& p_indexes);
     bool isFeasible=false;
     bool cover_mode=false;
     bool cover_mode_n2=false;
@@ -41,9 +78,7 @@ public:
     Solution_cap(shared_ptr<Instance> instance, unordered_set<uint_t> p_locations, const char* typeEVAL="GAPrelax", bool cover_mode=false);
     Solution_cap(shared_ptr<Instance> instance,
                  unordered_set<uint_t> p_locations,
-                 unordered_map<uint_t, dist_t> loc_usages, 
-                 unordered_map<uint_t, dist_t> cust_satisfactions, 
-                 unordered_map<uint_t, assignment> assignments);
+                 shared_ptr<CapAssignment> assign);
     void fullCapEval();
     void GAP_eval();
     void naiveEval();
@@ -59,9 +94,7 @@ public:
     void setLocUsage(uint_t loc, dist_t usage);
     void setCustSatisfaction(uint_t cust, dist_t satisfaction);
     void setAssigment(uint_t cust, assignment assigment);
-    unordered_map<uint_t, dist_t> getLocUsages();
-    unordered_map<uint_t, dist_t> getCustSatisfactions();
-    unordered_map<uint_t, assignment> getAssignments();
+    const CapAssignment& getCapAssignment() const;
     void saveAssignment(string output_filename,string Method, double timeFinal);
     void saveResults(string output_filename, double timeFinal, int numIter,string Method, string Method_sp="null", string Method_fp="null");
     void setFeasibility(bool feasible);
@@ -72,6 +105,7 @@ public:
     void setCoverMode(bool cover_mode);
     void setCoverMode_n2(bool cover_mode_n2);
     void add_UpperBound(double UB); 
+    void setGAPModel(shared_ptr<PMP> gap_model);
     void statsDistances();
     dist_t getMaxDist();
     dist_t getMinDist();
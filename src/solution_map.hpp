@@ -1,75 +1,142 @@
 #ifndef SOLUTION_MAP_H
 #define SOLUTION_MAP_H
 
-#include <vector>
+#include <list>
+#include <unordered_map>
 #include "solution_cap.hpp"
 
+#define SOLUTION_MAP_MAX_SIZE 20000 // stored solutions before the least recently used are dropped
+
+/*
+ * Cache of evaluated capacitated solutions, keyed by a fingerprint of their p-set.
+ * The fingerprint is the XOR of a 64-bit key per open location (Zobrist hashing):
+ * it does not depend on the order of the set and a swap updates it in O(1), so a
+ * candidate swap is looked up without building its p-set. A hit is still checked
+ * against the stored p-set, a collision is never returned as a match.
+ * Entries are kept in least recently used order and the oldest ones are dropped
+ * once max_size solutions are stored.
+ */
 class Solution_MAP {
 private:
+    typedef std::list<pair<uint64_t, Solution_cap>> entry_list;
+
     shared_ptr<Instance> instance;
-    std::vector<Solution_cap> solutions;
+    entry_list solutions; // most recently used first
+    std::unordered_map<uint64_t, entry_list::iterator> index;
+    size_t max_size = SOLUTION_MAP_MAX_SIZE;
+
+    // iterators point into the own list, rebuild them after a copy
+    void rebuildIndex() {
+        index.clear();
+        for (auto it = solutions.begin(); it != solutions.end(); ++it) index[it->first] = it;
+    }
+
+    void evict() {
+        while (solutions.size() > max_size) {
+            index.erase(solutions.back().first);
+            solutions.pop_back();
+        }
+    }
 
-    // Compare two sets for equality regardless of their ordering
-    // bool areSetsEqual(const std::unordered_set<uint_t>& set1, const std::unordered_set<uint_t>& set2) const {
-    //     return set1.size() == set2.size() && std::equal(set1.begin(), set1.end(), set2.begin());
-    // }
-    bool areSetsEqual(const std::unordered_set<uint_t>& set1, const std::unordered_set<uint_t>& set2) const {
-        return set1 == set2;
+    // Add a solution
+    void addSolution(uint64_t key, const Solution_cap& solution) {
+        solutions.emplace_front(key, solution);
+        index[key] = solutions.begin();
+        evict();
     }
-     // Add a solution 
-    void addSolution(const Solution_cap& solution) {
-        solutions.push_back(solution);
+
+    const Solution_cap* touch(entry_list::iterator it) {
+        solutions.splice(solutions.begin(), solutions, it);
+        return &it->second;
     }
 
 public:
     Solution_MAP() = default;
     Solution_MAP(shared_ptr<Instance> instance) : instance(std::move(instance)) {};
+    Solution_MAP(const Solution_MAP& other) : instance(other.instance), solutions(other.solutions), max_size(other.max_size) { rebuildIndex(); }
+    Solution_MAP(Solution_MAP&&) = default;
+    Solution_MAP& operator=(const Solution_MAP& other) {
+        if (this == &other) return *this;
+        instance = other.instance;
+        solutions = other.solutions;
+        max_size = other.max_size;
+        rebuildIndex();
+        return *this;
+    }
+    Solution_MAP& operator=(Solution_MAP&&) = default;
+
+    static uint64_t locationKey(uint_t loc) {
+        // splitmix64 finalizer, a fixed pseudo-random key per location id
+        uint64_t z = static_cast<uint64_t>(loc) + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
 
-    // Add a solution 
-    // void addSolution(const Solution_cap& solution) {
-    //     solutions.push_back(solution);
-    // }
+    static uint64_t fingerprint(const unordered_set<uint_t>& p_locations) {
+        uint64_t key = 0;
+        for (auto loc : p_locations) key ^= locationKey(loc);
+        return key;
+    }
+
+    // fingerprint of p_locations after closing loc_old and opening loc_new
+    static uint64_t swapFingerprint(uint64_t key, uint_t loc_old, uint_t loc_new) {
+        return key ^ locationKey(loc_old) ^ locationKey(loc_new);
+    }
 
     bool addUniqueSolution(const Solution_cap& newSolution) {
+        return addUniqueSolution(newSolution, fingerprint(newSolution.get_pLocations()));
+    }
+
+    bool addUniqueSolution(const Solution_cap& newSolution, uint64_t key) {
         if(newSolution.get_objective() == 0 || newSolution.get_pLocations().size() != instance->get_p()){
             return false;
         }
-        
-        if (!solutionExists(newSolution)) {
-            addSolution(newSolution);
+
+        auto it = index.find(key);
+        if (it == index.end()) {
+            addSolution(key, newSolution);
             return true;
-        }else{
+        }else if (it->second->second.get_pLocations() == newSolution.get_pLocations()){
             cout<<"Solution already exists"<<endl;
-            return false;   
+            touch(it->second);
+            return false;
         }
+        // fingerprint collision, keep the newer solution
+        solutions.erase(it->second);
+        index.erase(it);
+        addSolution(key, newSolution);
+        return true;
     }
 
-    // Check if a solution with the same p_locations already exists
-    bool solutionExists(const Solution_cap& newSolution) const {
-        for (const auto& solution : solutions) {
-            if (areSetsEqual(solution.get_pLocations(), newSolution.get_pLocations())) {
-                return true;
-            }
-        }
-        return false;
+    // Stored solution with the same p_locations, nullptr if there is none
+    const Solution_cap* find(const unordered_set<uint_t>& p_locations) {
+        auto it = index.find(fingerprint(p_locations));
+        if (it == index.end() || it->second->second.get_pLocations() != p_locations) return nullptr;
+        return touch(it->second);
     }
 
-    bool pSetExists(const unordered_set<uint_t>& p_locations) const {
-        for (const auto& solution : solutions) {
-            if (areSetsEqual(solution.get_pLocations(), p_locations)) {
-                return true;
-            }
-        }
-        return false;
+    /*
+     * Stored solution for p_locations with loc_old swapped for loc_new, where key is the
+     * fingerprint of p_locations. The swapped set is only compared on a fingerprint hit.
+     */
+    const Solution_cap* findSwap(uint64_t key, const unordered_set<uint_t>& p_locations, uint_t loc_old, uint_t loc_new) {
+        auto it = index.find(swapFingerprint(key, loc_old, loc_new));
+        if (it == index.end()) return nullptr;
+        const auto& stored = it->second->second.get_pLocations();
+        if (stored.size() != p_locations.size()) return nullptr;
+        for (auto loc : stored)
+            if (loc != loc_new && (loc == loc_old || p_locations.find(loc) == p_locations.end())) return nullptr;
+        return touch(it->second);
     }
 
-    int pSetExists_index(const std::unordered_set<uint_t>& p_locations) const {
-        for (size_t i = 0; i < solutions.size(); ++i) {
-            if (areSetsEqual(solutions[i].get_pLocations(), p_locations)) {
-                return static_cast<int>(i);  // Return the index when a match is found
-            }
-        }
-        return -1;  // Return -1 if no match is found
+    bool solutionExists(const Solution_cap& newSolution) const {
+        return pSetExists(newSolution.get_pLocations());
+    }
+
+    bool pSetExists(const unordered_set<uint_t>& p_locations) const {
+        auto it = index.find(fingerprint(p_locations));
+        return it != index.end() && it->second->second.get_pLocations() == p_locations;
     }
 
     // Get the number of stored solutions
@@ -77,35 +144,17 @@ public:
         return solutions.size();
     }
 
-    // Get a specific solution by index
-    const Solution_cap& getSolution(size_t index) const {
-        if (index < solutions.size()) {
-            return solutions[index];
-        } else {
-            // Handle out-of-range index
-            throw std::out_of_range("Index out of range");
-        }
+    void setMaxSize(size_t max_size) {
+        this->max_size = max(max_size, size_t(1));
+        evict();
     }
 
-    dist_t getObjectiveByIndex(int index) const {
-        if (index >= 0 && static_cast<size_t>(index) < solutions.size()) {
-            return solutions[index].get_objective();
-        } else {
-            // Handle invalid index, you might want to throw an exception or return a default value
-            std::cerr << "Invalid index: " << index << std::endl;
-            return -1.0;  // Return a default value, adjust as needed
-        }
-    }
-
-
     // For example, a method to print all stored solutions
     void printAllSolutions() {
-        for (auto& solution : solutions) {
-            solution.print();
+        for (auto& entry : solutions) {
+            entry.second.print();
         }
     }
-
-    // Add more methods as needed based on your requirements
 };
 
-#endif // SOLUTION_MAP_H
\ No newline at end of file
+#endif // SOLUTION_MAP_H
@@ -20,18 +20,41 @@ Solution_std::Solution_std(shared_ptr<Instance> instance, unordered_set<uint_t>
 void Solution_std::naiveEval() {
 //    assert(p_locations.size() == instance->get_p());
     
+    const auto& customers = instance->getCustomers();
+    closest_loc.assign(customers.size(), numeric_limits<uint_t>::max());
+    closest_dist.assign(customers.size(), numeric_limits<dist_t>::max());
+    second_loc.assign(customers.size(), numeric_limits<uint_t>::max());
+    second_dist.assign(customers.size(), numeric_limits<dist_t>::max());
+
     objective = 0;
-    for (auto cust:instance->getCustomers()) {
-        auto loc = getClosestpLoc(cust);
-        
-        auto dist = instance->getRealDist(loc, cust);
-        if (is_weighted_obj_func){dist = instance->getWeightedDist(loc, cust);}
+    for (uint_t i = 0; i < customers.size(); i++) {
+        updateClosest(i);
+        objective += closest_dist[i];
+    }
+}
 
-        // auto dist = instance->getWeightedDist(loc, cust);
+dist_t Solution_std::evalDist(uint_t loc, uint_t cust) {
+    if (is_weighted_obj_func) return instance->getWeightedDist(loc, cust);
+    return instance->getRealDist(loc, cust);
+}
 
-        objective += dist;
-        assignment[cust] = my_pair{loc, dist};
+// Rescan the p locations for the closest and second-closest one of a customer
+void Solution_std::updateClosest(uint_t cust_index) {
+    uint_t loc1 = numeric_limits<uint_t>::max(), loc2 = numeric_limits<uint_t>::max();
+    dist_t dist1 = numeric_limits<dist_t>::max(), dist2 = numeric_limits<dist_t>::max();
+    for (auto loc:p_locations) {
+        dist_t dist = evalDistByIdx(loc, instance->getLocIndex(loc), cust_index);
+        if (dist <= dist1) {
+            loc2 = loc1; dist2 = dist1;
+            loc1 = loc; dist1 = dist;
+        } else if (dist <= dist2) {
+            loc2 = loc; dist2 = dist;
+        }
     }
+    closest_loc[cust_index] = loc1;
+    closest_dist[cust_index] = dist1;
+    second_loc[cust_index] = loc2;
+    second_dist[cust_index] = dist2;
 }
 
 uint_t Solution_std::getClosestpLoc(uint_t cust) {
@@ -40,9 +63,7 @@ uint_t Solution_std::getClosestpLoc(uint_t cust) {
     uint_t loc_closest=numeric_limits<uint_t>::max();
     for (auto loc:p_locations) {
         
-        dist_t dist =  instance->getRealDist(loc, cust);
-        if (is_weighted_obj_func){dist = instance->getWeightedDist(loc, cust);}
-
+        dist_t dist = evalDist(loc, cust);
 
         if (dist <= dist_min) {
             dist_min = dist;
@@ -90,33 +111,52 @@ const vector<uint_t> &Solution_std::get_Locations() const {
 void Solution_std::replaceLocation(uint_t loc_old, uint_t loc_new) {
     // Update p_locations
 
-     if(!(p_locations.find(loc_old) == p_locations.end()) && !(p_locations.find(loc_new) != p_locations.end())){
-    p_locations.erase(loc_old);
-    p_locations.insert(loc_new);
+    if(!(p_locations.find(loc_old) == p_locations.end()) && !(p_locations.find(loc_new) != p_locations.end())){
+        p_locations.erase(loc_old);
+        p_locations.insert(loc_new);
+
+        // Update closest/second-closest caches, rescan only customers that lost one of them
+        const auto& customers = instance->getCustomers();
+        auto loc_new_index = instance->getLocIndex(loc_new);
+        objective = 0;
+        for (uint_t i = 0; i < customers.size(); i++) {
+            if (closest_loc[i] == loc_old || second_loc[i] == loc_old) {
+                updateClosest(i);
+            } else {
+                auto dist_new = evalDistByIdx(loc_new, loc_new_index, i);
+                if (dist_new <= closest_dist[i]) {
+                    second_loc[i] = closest_loc[i]; second_dist[i] = closest_dist[i];
+                    closest_loc[i] = loc_new; closest_dist[i] = dist_new;
+                } else if (dist_new <= second_dist[i]) {
+                    second_loc[i] = loc_new; second_dist[i] = dist_new;
+                }
+            }
+            objective += closest_dist[i];
+        }
 
-    naiveEval();
-     
     }else{
         cout << "ERROR: loc_old not in p_locations or loc_new in p_locations" << endl;
         
     }
-//     // Update assignment and objective
-//     for (auto cust:instance->getCustomers()) {
-//         auto dist_old = assignment[cust].dist;
-//         auto dist_new = instance->getWeightedDist(loc_new, cust);
-//         if (assignment[cust].node == loc_old) { // cust must be reassigned to some other p location
-//             auto loc_closest = getClosestpLoc(cust);
-//             auto dist_closest = instance->getWeightedDist(loc_closest, cust);
-//             assignment[cust] = my_pair {loc_closest, dist_closest};
-//             objective -= dist_old;
-//             objective += dist_closest;
-//         } else if (dist_old - dist_new > TOLERANCE_OBJ) { // cust may be reassigned to loc_new
-//             assignment[cust] = my_pair {loc_new, dist_new};
-//             objective -= dist_old;
-//             objective += dist_new;
-//         }
-// //        cout << cust << " " << assignment[cust].node << " " << assignment[cust].dist << endl;
-//     }
+}
+
+/*
+ * Objective change of swapping loc_out (in p) with loc_in (not in p), without modifying the solution.
+ * Uses the closest/second-closest caches, O(n).
+ */
+dist_t Solution_std::swapDelta(uint_t loc_out, uint_t loc_in) {
+    const auto& customers = instance->getCustomers();
+    auto loc_in_index = instance->getLocIndex(loc_in);
+    dist_t delta = 0;
+    for (uint_t i = 0; i < customers.size(); i++) {
+        auto dist_in = evalDistByIdx(loc_in, loc_in_index, i);
+        if (closest_loc[i] == loc_out) {
+            delta += min(dist_in, second_dist[i]) - closest_dist[i];
+        } else if (dist_in < closest_dist[i]) {
+            delta += dist_in - closest_dist[i];
+        }
+    }
+    return delta;
 }
 
 dist_t Solution_std::get_objective() {
@@ -179,12 +219,13 @@ void Solution_std::saveAssignment(string output_filename,string Method, double t
     for (auto p_loc:p_locations) cout << p_loc << endl;
     cout << endl;
 
+    const auto& customers = instance->getCustomers();
     cout << "LOCATION ASSIGNMENTS\nlocation: customers\n";
     for (auto loc:p_locations) {
         cout << loc << ": ";
-        for (auto cust:instance->getCustomers()) {
-            if (assignment[cust].node == loc) {
-                cout << cust << " ";
+        for (uint_t i = 0; i < customers.size(); i++) {
+            if (closest_loc[i] == loc) {
+                cout << customers[i] << " ";
             }
         }
         cout << endl;
@@ -194,10 +235,10 @@ void Solution_std::saveAssignment(string output_filename,string Method, double t
     cout << "DISTANCES\nlocation: customers (distance)\n";
     for (auto loc:p_locations) {
         cout << loc << ": ";
-        for (auto cust:instance->getCustomers()) {
-            if (assignment[cust].node == loc) {
-                cout << cust << " ";
-                cout << "(" << instance->getWeightedDist(loc, cust) << ") ";
+        for (uint_t i = 0; i < customers.size(); i++) {
+            if (closest_loc[i] == loc) {
+                cout << customers[i] << " ";
+                cout << "(" << instance->getWeightedDist(loc, customers[i]) << ") ";
             }
         }
         cout << endl;
@@ -302,16 +343,16 @@ bool Solution_std::isSolutionFeasible() {
 
 void Solution_std::statsDistances() {
     dist_t sum = 0;
-    for (auto cust:instance->getCustomers()) {
-        sum += assignment[cust].dist;
-        if (assignment[cust].dist > max_dist) max_dist = assignment[cust].dist;
-        if (assignment[cust].dist < min_dist) min_dist = assignment[cust].dist;
+    for (auto dist:closest_dist) {
+        sum += dist;
+        if (dist > max_dist) max_dist = dist;
+        if (dist < min_dist) min_dist = dist;
     }
-    avg_dist = sum / instance->getCustomers().size();
-    for (auto cust:instance->getCustomers()) {
-        std_dev_dist += pow(assignment[cust].dist - avg_dist, 2);
+    avg_dist = sum / closest_dist.size();
+    for (auto dist:closest_dist) {
+        std_dev_dist += pow(dist - avg_dist, 2);
     }
-    std_dev_dist = sqrt(std_dev_dist / instance->getCustomers().size());
+    std_dev_dist = sqrt(std_dev_dist / closest_dist.size());
 
     this->max_dist = max_dist;
     this->min_dist = min_dist;
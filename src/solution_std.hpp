@@ -17,7 +17,12 @@ private:
     dist_t objective; // objective value
     shared_ptr<Instance> instance; // solved instance
 
-    unordered_map<uint_t, my_pair> assignment; // customer -> p location, distance to it
+    // closest and second-closest open p location of each customer, indexed by the
+    // customer position in instance->getCustomers() (distances are objective terms)
+    vector<uint_t> closest_loc;
+    vector<dist_t> closest_dist;
+    vector<uint_t> second_loc;
+    vector<dist_t> second_dist;
 
     bool cover_mode = false;
     bool cover_mode_n2 = false;
@@ -27,6 +32,8 @@ private:
     dist_t min_dist=numeric_limits<dist_t>::max();;
     dist_t avg_dist=0;
     dist_t std_dev_dist=0; 
+
+    void updateClosest(uint_t cust_index);
 public:
 
     Solution_std() = default;
@@ -38,6 +45,17 @@ public:
     const vector<uint_t> & get_Locations() const;
     void print();
     void replaceLocation(uint_t loc_old, uint_t loc_new);
+    dist_t swapDelta(uint_t loc_out, uint_t loc_in);
+    dist_t evalDist(uint_t loc, uint_t cust);
+    // evalDist through the dense indexes; loc_index is NO_INDEX for a location outside the instance
+    dist_t evalDistByIdx(uint_t loc, uint_t loc_index, uint_t cust_index) {
+        if (loc_index == NO_INDEX) return evalDist(loc, instance->getCustomers()[cust_index]);
+        if (is_weighted_obj_func) return instance->weightByIdx(cust_index) * instance->distByIdx(loc_index, cust_index);
+        return instance->distByIdx(loc_index, cust_index);
+    }
+    const vector<uint_t>& getClosestLocs() const { return closest_loc; }
+    const vector<dist_t>& getClosestDists() const { return closest_dist; }
+    const vector<dist_t>& getSecondDists() const { return second_dist; }
     dist_t get_objective();
     void saveAssignment(string output_filename,string Method, double timeFinal);
     void saveResults(string output_filename, double timeFinal, int numIter,string Method, string Method_sp="null", string Method_fp="null");
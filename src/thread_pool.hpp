@@ -0,0 +1,89 @@
+#ifndef LARGE_PMP_THREAD_POOL_HPP
+#define LARGE_PMP_THREAD_POOL_HPP
+
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed set of worker threads taking tasks from a shared FIFO queue.
+ * A worker picks the next task as soon as its current one is done, so a
+ * long task only keeps its own worker busy.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int thread_cnt) {
+        if (thread_cnt == 0) thread_cnt = 1;
+        for (unsigned int t = 0; t < thread_cnt; t++)
+            workers.emplace_back([this, t]() { workerIndex() = t; work(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv_task.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    inline void submit(std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            tasks.push(std::move(task));
+            pending++;
+        }
+        cv_task.notify_one();
+    }
+
+    // block until every submitted task has finished
+    inline void wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv_done.wait(lock, [this]() { return pending == 0; });
+    }
+
+    inline unsigned int size() const {
+        return workers.size();
+    }
+
+    // index of the calling thread in its pool (0..size-1), -1 outside a pool
+    static inline int& workerIndex() {
+        static thread_local int index = -1;
+        return index;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mtx;
+    std::condition_variable cv_task;
+    std::condition_variable cv_done;
+    unsigned int pending = 0; // submitted and not finished
+    bool stop = false;
+
+    void work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv_task.wait(lock, [this]() { return stop || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                if (--pending == 0) cv_done.notify_all();
+            }
+        }
+    }
+};
+
+#endif //LARGE_PMP_THREAD_POOL_HPP
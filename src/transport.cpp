@@ -0,0 +1,327 @@
+#include "transport.hpp"
+#include <queue>
+#include <cmath>
+#include <algorithm>
+
+#define FLOW_EPS 1e-9
+
+Transport::Transport(const shared_ptr<Instance>& instance, const unordered_set<uint_t>& p_locations) {
+    this->instance = instance;
+    this->facilities.assign(p_locations.begin(), p_locations.end());
+    for (auto loc:facilities) facility_indexes.push_back(instance->getLocIndex(loc));
+    this->is_weighted_obj_func = instance->get_isWeightedObjFunc();
+    this->threshold_dist = instance->get_ThresholdDist();
+
+    this->num_customers = instance->getCustomers().size();
+    residual.resize(facilities.size());
+    for (uint_t s = 0; s < facilities.size(); s++) residual[s] = instance->getLocCapacity(facilities[s]);
+    potential.assign(facilities.size(), 0);
+    for (uint_t s = 0; s < facilities.size(); s++) slot_custs.push_back(make_shared<unordered_set<uint_t>>());
+    slot_owned.assign(facilities.size(), true);
+
+    for (uint_t first = 0; first < num_customers; first += TRANSPORT_BLOCK) {
+        auto block = make_shared<CustBlock>();
+        auto size = min<uint_t>(TRANSPORT_BLOCK, num_customers - first);
+        block->flows.resize(size);
+        for (uint_t i = first; i < first + size; i++) block->supply.push_back(instance->weightByIdx(i));
+        blocks.push_back(block);
+    }
+    block_owned.assign(blocks.size(), true);
+}
+
+// shares the blocks and the slot sets of other, nothing is owned yet
+Transport::Transport(const Transport& other)
+    : instance(other.instance), num_customers(other.num_customers), facilities(other.facilities),
+      facility_indexes(other.facility_indexes), residual(other.residual), potential(other.potential),
+      potential_sink(other.potential_sink), blocks(other.blocks), slot_custs(other.slot_custs),
+      block_owned(other.blocks.size(), false), slot_owned(other.slot_custs.size(), false),
+      objective(other.objective), objective_weighted(other.objective_weighted),
+      is_weighted_obj_func(other.is_weighted_obj_func), threshold_dist(other.threshold_dist),
+      UpperBound(other.UpperBound), isFeasible(other.isFeasible) {}
+
+Transport::CustBlock& Transport::ownBlock(uint_t cust_index) {
+    auto b = cust_index / TRANSPORT_BLOCK;
+    if (!block_owned[b]) {
+        blocks[b] = make_shared<CustBlock>(*blocks[b]);
+        block_owned[b] = true;
+    }
+    return *blocks[b];
+}
+
+unordered_set<uint_t>& Transport::ownSlotCusts(uint_t slot) {
+    if (!slot_owned[slot]) {
+        slot_custs[slot] = make_shared<unordered_set<uint_t>>(*slot_custs[slot]);
+        slot_owned[slot] = true;
+    }
+    return *slot_custs[slot];
+}
+
+dist_t Transport::slotDist(uint_t cust_index, uint_t slot) {
+    if (facility_indexes[slot] == NO_INDEX) return instance->getRealDist(facilities[slot], instance->getCustomers()[cust_index]);
+    return instance->distByIdx(facility_indexes[slot], cust_index);
+}
+
+// cost of one unit of demand of customer i served by slot s (infinite if not allowed)
+dist_t Transport::unitCost(uint_t cust_index, uint_t slot) {
+    auto dist = slotDist(cust_index, slot);
+    if (threshold_dist > 0 && dist > threshold_dist) return numeric_limits<dist_t>::max();
+    if (is_weighted_obj_func) return dist;
+    return dist / instance->weightByIdx(cust_index);
+}
+
+void Transport::addFlow(uint_t cust_index, uint_t slot, dist_t amount) {
+    objective += amount * unitCost(cust_index, slot);
+    objective_weighted += amount * slotDist(cust_index, slot);
+
+    auto& cust_flows = ownBlock(cust_index).flows[cust_index % TRANSPORT_BLOCK];
+    for (uint_t k = 0; k < cust_flows.size(); k++) {
+        if (cust_flows[k].first != slot) continue;
+        cust_flows[k].second += amount;
+        if (cust_flows[k].second <= FLOW_EPS) {
+            cust_flows.erase(cust_flows.begin() + k);
+            ownSlotCusts(slot).erase(cust_index);
+        }
+        return;
+    }
+    if (amount > FLOW_EPS) {
+        cust_flows.emplace_back(slot, amount);
+        ownSlotCusts(slot).insert(cust_index);
+    }
+}
+
+void Transport::addSupply(uint_t cust_index, dist_t amount) {
+    ownBlock(cust_index).supply[cust_index % TRANSPORT_BLOCK] += amount;
+}
+
+// Send all flow of a customer back to its supply; slots that gain spare capacity
+// must have the sink potential, raising it is reported in raised
+void Transport::unroute(uint_t cust_index, vector<uint_t>& raised) {
+    auto cust_flows = flows(cust_index);
+    for (auto f : cust_flows) {
+        addFlow(cust_index, f.first, -f.second);
+        addSupply(cust_index, f.second);
+        residual[f.first] += f.second;
+        if (potential[f.first] < potential_sink) {
+            potential[f.first] = potential_sink;
+            raised.push_back(f.first);
+        }
+    }
+}
+
+/*
+ * Route demand of customer cust_index along one shortest path to the sink.
+ * Nodes of the search are the p slots (0..p-1) and the sink (p); a slot j reaches
+ * slot k by moving the flow of some customer i from j to k. Returns false if the
+ * remaining demand cannot be routed (infeasible).
+ */
+bool Transport::augment(uint_t cust_index) {
+    uint_t num_slots = facilities.size();
+    uint_t sink = num_slots;
+    uint_t none = numeric_limits<uint_t>::max();
+    dist_t inf = numeric_limits<dist_t>::max();
+
+    vector<dist_t> label(num_slots + 1, inf);
+    vector<bool> done(num_slots + 1, false);
+    vector<uint_t> pred_slot(num_slots + 1, none), pred_cust(num_slots + 1, none);
+    priority_queue<pair<dist_t, uint_t>, vector<pair<dist_t, uint_t>>, greater<pair<dist_t, uint_t>>> heap;
+
+    dist_t red_min = inf;
+    vector<dist_t> red(num_slots, inf);
+    for (uint_t s = 0; s < num_slots; s++) {
+        auto cost = unitCost(cust_index, s);
+        if (cost == inf) continue;
+        red[s] = cost - potential[s];
+        red_min = min(red_min, red[s]);
+    }
+    if (red_min == inf) return false;
+    for (uint_t s = 0; s < num_slots; s++) {
+        if (red[s] == inf) continue;
+        label[s] = red[s] - red_min;
+        heap.emplace(label[s], s);
+    }
+
+    while (!heap.empty()) {
+        auto top = heap.top();
+        heap.pop();
+        auto v = top.second;
+        if (done[v] || top.first > label[v]) continue;
+        done[v] = true;
+        if (v == sink) break;
+
+        if (residual[v] > FLOW_EPS) {
+            auto cand = top.first + max(dist_t(0), potential[v] - potential_sink);
+            if (cand < label[sink]) {
+                label[sink] = cand;
+                pred_slot[sink] = v;
+                heap.emplace(cand, sink);
+            }
+        }
+        for (auto i : *slot_custs[v]) {
+            auto red_iv = unitCost(i, v) - potential[v];
+            for (uint_t k = 0; k < num_slots; k++) {
+                if (done[k]) continue;
+                auto cost = unitCost(i, k);
+                if (cost == inf) continue;
+                auto cand = top.first + max(dist_t(0), (cost - potential[k]) - red_iv);
+                if (cand < label[k]) {
+                    label[k] = cand;
+                    pred_slot[k] = v;
+                    pred_cust[k] = i;
+                    heap.emplace(cand, k);
+                }
+            }
+        }
+    }
+    if (!done[sink]) return false;
+
+    // keep reduced costs non-negative for the next search
+    auto dist_sink = label[sink];
+    for (uint_t s = 0; s < num_slots; s++) potential[s] += min(label[s], dist_sink);
+    potential_sink += dist_sink;
+
+    // bottleneck: remaining demand, sink capacity and the flows moved along the path
+    auto t = pred_slot[sink];
+    auto amount = min(supply(cust_index), residual[t]);
+    for (auto k = t; pred_slot[k] != none; k = pred_slot[k]) {
+        for (auto& f : flows(pred_cust[k]))
+            if (f.first == pred_slot[k]) amount = min(amount, f.second);
+    }
+
+    residual[t] -= amount;
+    addSupply(cust_index, -amount);
+    auto k = t;
+    while (pred_slot[k] != none) {
+        auto i = pred_cust[k], j = pred_slot[k];
+        addFlow(i, k, amount);
+        addFlow(i, j, -amount);
+        k = j;
+    }
+    addFlow(cust_index, k, amount);
+    return true;
+}
+
+bool Transport::routeSupplies(const vector<uint_t>& cust_indexes) {
+    isFeasible = true;
+    for (auto i : cust_indexes) {
+        while (supply(i) > FLOW_EPS) {
+            if (!augment(i)) {
+                isFeasible = false;
+                return isFeasible;
+            }
+        }
+    }
+    // same cut as constr_UpperBound: sum (wi * dij * xij) <= UB
+    if (UpperBound > 0 && objective_weighted > UpperBound) isFeasible = false;
+    return isFeasible;
+}
+
+bool Transport::run() {
+
+    dist_t total_capacity = 0;
+    for (auto cap : residual) total_capacity += cap;
+    if (total_capacity < instance->getTotalDemand()) {
+        isFeasible = false;
+        return isFeasible;
+    }
+
+    vector<uint_t> cust_indexes(num_customers);
+    for (uint_t i = 0; i < num_customers; i++) cust_indexes[i] = i;
+    return routeSupplies(cust_indexes);
+}
+
+/*
+ * Warm re-solve after swapping loc_old for loc_new. The demand served by loc_old is
+ * freed and loc_new enters its slot with the sink potential (spare capacity, least
+ * attractive). Customers whose current location is then no longer the cheapest in
+ * reduced cost are freed as well, which may raise the potential of the locations
+ * they leave and free more customers. Only the freed demand is routed again.
+ * Finding the attracted customers takes one pass over the customers per wave of
+ * raised slots (there is no location -> customers index), the rest of the work and
+ * the copied state are proportional to the freed customers.
+ */
+bool Transport::replaceFacility(uint_t loc_old, uint_t loc_new) {
+
+    auto it = find(facilities.begin(), facilities.end(), loc_old);
+    if (it == facilities.end()) {
+        cerr << "[ERROR] Transport: location " << loc_old << " is not open" << endl;
+        isFeasible = false;
+        return isFeasible;
+    }
+    uint_t s = it - facilities.begin();
+    dist_t inf = numeric_limits<dist_t>::max();
+
+    vector<uint_t> to_route(slot_custs[s]->begin(), slot_custs[s]->end());
+    for (auto i : to_route) {
+        for (auto f : flows(i)) {
+            if (f.first != s) continue;
+            addFlow(i, s, -f.second);
+            addSupply(i, f.second);
+            break;
+        }
+    }
+    facilities[s] = loc_new;
+    facility_indexes[s] = instance->getLocIndex(loc_new);
+    residual[s] = instance->getLocCapacity(loc_new);
+    potential[s] = potential_sink;
+
+    // a customer is freed if a raised slot is cheaper in reduced cost than one of its flows
+    vector<uint_t> raised = {s}, wave;
+    while (!raised.empty()) {
+        wave.swap(raised);
+        raised.clear();
+        for (uint_t i = 0; i < num_customers; i++) {
+            const auto& cust_flows = flows(i);
+            if (cust_flows.empty()) continue;
+            dist_t red_max = -inf;
+            for (auto f : cust_flows) red_max = max(red_max, unitCost(i, f.first) - potential[f.first]);
+            for (auto j : wave) {
+                auto cost_j = unitCost(i, j);
+                if (cost_j != inf && cost_j - potential[j] < red_max - FLOW_EPS) {
+                    unroute(i, raised);
+                    to_route.push_back(i);
+                    break;
+                }
+            }
+        }
+    }
+
+    return routeSupplies(to_route);
+}
+
+bool Transport::getFeasibility() const {
+    return isFeasible;
+}
+
+dist_t Transport::getObjective() {
+    if (!isFeasible) return numeric_limits<dist_t>::max();
+    return objective;
+}
+
+// The flow as the assignment of a Solution_cap, written in customer order (no staging needed)
+shared_ptr<CapAssignment> Transport::getAssignment() {
+
+    auto assign = make_shared<CapAssignment>(instance->getLocations().size(), num_customers);
+    for (uint_t s = 0; s < facilities.size(); s++)
+        if (facility_indexes[s] != NO_INDEX) assign->loc_usages[facility_indexes[s]] = instance->getLocCapacity(facilities[s]) - residual[s];
+
+    for (uint_t i = 0; i < num_customers; i++) {
+        for (auto f : flows(i)) {
+            assign->cust_satisfactions[i] += f.second;
+            assign->entries.emplace_back(my_tuple{facilities[f.first], f.second, slotDist(i, f.first)});
+        }
+        assign->offsets[i + 1] = assign->entries.size();
+    }
+    return assign;
+}
+
+Solution_cap Transport::getSolution_cap() {
+
+    unordered_set<uint_t> p_locations(facilities.begin(), facilities.end());
+    Solution_cap sol(instance, p_locations, getAssignment());
+    sol.setFeasibility(isFeasible);
+    return sol;
+}
+
+void Transport::setUpperBound(dist_t UB) {
+    this->UpperBound = UB;
+}
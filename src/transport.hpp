@@ -0,0 +1,82 @@
+#ifndef LARGE_PMP_TRANSPORT_HPP
+#define LARGE_PMP_TRANSPORT_HPP
+
+#include <utility>
+#include <unordered_set>
+#include <vector>
+#include "globals.hpp"
+#include "instance.hpp"
+#include "solution_cap.hpp"
+
+using namespace std;
+
+/*
+ * Transportation problem for fixed p locations (GAP with continuous x, "GAPrelax"),
+ * solved as a min-cost flow by successive shortest paths:
+ *   customer i supplies w_i units, p location j absorbs at most capacity_j units,
+ *   a unit sent from i to j costs d_ij (weighted objective) or d_ij / w_i (unweighted).
+ * Potentials are kept only on the p locations (plus the sink); a customer only
+ * carries flow to locations minimizing cost(i,j) - potential[j], so every shortest
+ * path search is a Dijkstra over the p locations.
+ * The flow and the potentials are kept, so a swap of one p location (replaceFacility)
+ * only re-routes the customers of the closed location and those attracted by the
+ * opened one. A copy shares the per-customer state (blocks of TRANSPORT_BLOCK customers)
+ * and the per-slot customer sets with its source and clones a block or a set on its
+ * first write, so a warm re-solve copies only what it touches. A Transport is modified
+ * only before it is copied (Solution_cap copies the shared one before each swap).
+ */
+#define TRANSPORT_BLOCK 256 // customers per copy-on-write block
+
+class Transport {
+private:
+    typedef vector<pair<uint_t, dist_t>> CustFlows; // (slot, flow)
+    struct CustBlock {
+        vector<dist_t> supply;   // demand not routed yet
+        vector<CustFlows> flows;
+    };
+
+    shared_ptr<Instance> instance;
+    uint_t num_customers;
+    vector<uint_t> facilities;                  // slot -> p location
+    vector<uint_t> facility_indexes;            // slot -> location index in the instance
+    vector<dist_t> residual;                    // slot -> remaining capacity
+    vector<dist_t> potential;                   // slot -> node potential
+    dist_t potential_sink = 0;
+    vector<shared_ptr<CustBlock>> blocks;       // customer index / TRANSPORT_BLOCK -> block
+    vector<shared_ptr<unordered_set<uint_t>>> slot_custs; // slot -> customer indexes with flow
+    vector<bool> block_owned, slot_owned;       // cloned by this copy, safe to modify
+    dist_t objective = 0;                       // sum of flow * unit cost
+    dist_t objective_weighted = 0;              // sum of flow * distance (UpperBound cut)
+    bool is_weighted_obj_func;
+    dist_t threshold_dist;
+    dist_t UpperBound = 0;
+    bool isFeasible = false;
+
+    const CustFlows& flows(uint_t cust_index) const {
+        return blocks[cust_index / TRANSPORT_BLOCK]->flows[cust_index % TRANSPORT_BLOCK];
+    }
+    dist_t supply(uint_t cust_index) const {
+        return blocks[cust_index / TRANSPORT_BLOCK]->supply[cust_index % TRANSPORT_BLOCK];
+    }
+    CustBlock& ownBlock(uint_t cust_index);
+    unordered_set<uint_t>& ownSlotCusts(uint_t slot);
+    dist_t slotDist(uint_t cust_index, uint_t slot);
+    dist_t unitCost(uint_t cust_index, uint_t slot);
+    void addFlow(uint_t cust_index, uint_t slot, dist_t amount);
+    void addSupply(uint_t cust_index, dist_t amount);
+    bool augment(uint_t cust_index);
+    void unroute(uint_t cust_index, vector<uint_t>& raised);
+    bool routeSupplies(const vector<uint_t>& cust_indexes);
+public:
+    Transport(const shared_ptr<Instance>& instance, const unordered_set<uint_t>& p_locations);
+    Transport(const Transport& other);
+    bool run();
+    bool replaceFacility(uint_t loc_old, uint_t loc_new);
+    bool getFeasibility() const;
+    dist_t getObjective();
+    Solution_cap getSolution_cap();
+    shared_ptr<CapAssignment> getAssignment();
+    void setUpperBound(dist_t UB);
+};
+
+#endif //LARGE_PMP_TRANSPORT_HPP
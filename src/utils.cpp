@@ -13,9 +13,27 @@ void tock(chrono::steady_clock::time_point start) {
     cout << "Elapsed time: " << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms" << endl << endl;
 }
 
-vector<uint_t> getRandomSubvector(vector<uint_t> orig_vector, uint_t new_size, default_random_engine *generator) {
-    shuffle(orig_vector.begin(), orig_vector.end(), *generator);
-    return vector<uint_t>(orig_vector.begin(), orig_vector.begin() + new_size);
+/*
+ * new_size distinct elements drawn uniformly from orig_vector: the first new_size steps of a
+ * Fisher-Yates shuffle, where the swapped positions are kept in a map instead of copying
+ * orig_vector, so a sample costs O(new_size) whatever the size of orig_vector.
+ */
+vector<uint_t> getRandomSubvector(const vector<uint_t>& orig_vector, uint_t new_size, default_random_engine *generator) {
+    uint_t size = orig_vector.size();
+    new_size = min(new_size, size);
+    unordered_map<uint_t, uint_t> swapped; // position -> element moved there
+    auto elementAt = [&](uint_t pos) {
+        auto it = swapped.find(pos);
+        return it == swapped.end() ? orig_vector[pos] : it->second;
+    };
+    vector<uint_t> sample(new_size);
+    for (uint_t i = 0; i < new_size; i++) {
+        uniform_int_distribution<uint_t> distribution(i, size - 1);
+        auto j = distribution(*generator);
+        sample[i] = elementAt(j);
+        swapped[j] = elementAt(i);
+    }
+    return sample;
 }
 
 bool sortbysec(const pair<int,int> &a, const pair<int,int> &b) {
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <vector>
+#include <unordered_map>
 #include <algorithm>
 #include "globals.hpp"
 #include "utils.hpp"
@@ -16,7 +17,7 @@ using namespace std;
 
 chrono::steady_clock::time_point tick();
 void tock(chrono::steady_clock::time_point start);
-vector<uint_t> getRandomSubvector(vector<uint_t> orig_vector, uint_t new_size, default_random_engine *generator);
+vector<uint_t> getRandomSubvector(const vector<uint_t>& orig_vector, uint_t new_size, default_random_engine *generator);
 bool sortbysec(const pair<int,int> &a, const pair<int,int> &b);
 bool cmpPair2nd(pair<uint_t, double>& a, pair<uint_t, double>& b);
 